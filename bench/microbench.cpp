@@ -0,0 +1,387 @@
+#include "../include/analyzer.hpp"
+#include "../include/csv.hpp"
+#include "../include/indicators.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file microbench.cpp
+ * @brief Microbenchmarks for every hot-path function of the analyzer
+ *
+ * Each benchmark runs a warm-up phase, then a fixed number of repetitions of
+ * a timed batch of operations. The median and median absolute deviation (MAD)
+ * of the per-operation time across repetitions are reported as JSON on
+ * stdout, so results can be diffed per function between commits.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o bench_micro \
+ *       bench/microbench.cpp
+ *   ./bench_micro [--reps=N] [--filter=SUBSTRING] > bench.json
+ */
+
+/**
+ * @brief Prevents the compiler from optimizing away a computed value
+ */
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @struct BenchResult
+ * @brief Summary statistics of one benchmark
+ */
+struct BenchResult {
+  std::string name;     ///< Benchmark name (function under test + variant)
+  size_t batch = 0;     ///< Operations per timed repetition
+  size_t reps = 0;      ///< Number of timed repetitions
+  double median_ns = 0; ///< Median time per operation
+  double mad_ns = 0;    ///< Median absolute deviation of time per operation
+  double min_ns = 0;    ///< Fastest repetition's time per operation
+};
+
+/**
+ * @class BenchRunner
+ * @brief Minimal self-contained benchmark harness
+ */
+class BenchRunner {
+  size_t reps;                      ///< Timed repetitions per benchmark
+  std::string filter;               ///< Only run names containing this
+  std::vector<BenchResult> results; ///< Completed benchmarks
+
+  /**
+   * @brief Returns the median of a vector (sorts it)
+   */
+  static double median(std::vector<double> &values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+  }
+
+public:
+  BenchRunner(size_t repetitions, std::string name_filter)
+      : reps(repetitions), filter(std::move(name_filter)) {}
+
+  /**
+   * @brief Runs one benchmark
+   * @param name Benchmark name
+   * @param batch Operations per timed repetition
+   * @param op Callable invoked as op(i) for i in [0, batch)
+   *
+   * Warm-up runs whole batches until 50ms have passed (at least one), so
+   * caches, branch predictors and lazily allocated state are settled before
+   * the timed repetitions start.
+   */
+  template <typename Op>
+  void run(const std::string &name, size_t batch, Op &&op) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) {
+      return;
+    }
+    using clock = std::chrono::steady_clock;
+
+    auto warm_until = clock::now() + std::chrono::milliseconds(50);
+    do {
+      for (size_t i = 0; i < batch; ++i) {
+        op(i);
+      }
+    } while (clock::now() < warm_until);
+
+    std::vector<double> per_op(reps);
+    for (size_t r = 0; r < reps; ++r) {
+      auto start = clock::now();
+      for (size_t i = 0; i < batch; ++i) {
+        op(i);
+      }
+      auto elapsed = clock::now() - start;
+      per_op[r] =
+          std::chrono::duration<double, std::nano>(elapsed).count() / batch;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.batch = batch;
+    result.reps = reps;
+    result.min_ns = *std::min_element(per_op.begin(), per_op.end());
+    result.median_ns = median(per_op);
+    std::vector<double> deviations(reps);
+    for (size_t r = 0; r < reps; ++r) {
+      deviations[r] = std::abs(per_op[r] - result.median_ns);
+    }
+    result.mad_ns = median(deviations);
+
+    std::cerr << name << ": " << result.median_ns << " ns/op (MAD "
+              << result.mad_ns << ")\n";
+    results.push_back(result);
+  }
+
+  /**
+   * @brief Writes all results as a JSON document
+   */
+  void write_json(std::ostream &out) const {
+    out << "{\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchResult &r = results[i];
+      out << "    {\"name\": \"" << r.name << "\", \"median\": " << r.median_ns
+          << ", \"mad\": " << r.mad_ns << ", \"min\": " << r.min_ns
+          << ", \"batch\": " << r.batch << ", \"reps\": " << r.reps << "}"
+          << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+  }
+};
+
+/**
+ * @class NullBuffer
+ * @brief Stream buffer that discards everything (isolates formatting cost)
+ */
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char *, std::streamsize n) override {
+    return n;
+  }
+};
+
+/**
+ * @brief Builds deterministic input lines shaped like real market data
+ * @param count Number of lines
+ * @param symbols Number of distinct symbols
+ */
+std::vector<std::string> make_lines(size_t count, size_t symbols) {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> price(50.0, 500.0);
+  std::uniform_int_distribution<int> volume(100, 5000);
+  std::vector<std::string> lines;
+  lines.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    int second = static_cast<int>(i % 60);
+    int minute = static_cast<int>((i / 60) % 60);
+    char ts[32];
+    std::snprintf(ts, sizeof(ts), "2023-09-15 10:%02d:%02d", minute, second);
+    char px[32];
+    std::snprintf(px, sizeof(px), "%.2f", price(rng));
+    std::string symbol = "SYM" + std::to_string(rng() % symbols);
+    lines.push_back(std::string(ts) + "," + symbol + "," + px + "," +
+                    std::to_string(volume(rng)));
+  }
+  return lines;
+}
+
+/**
+ * @brief Entry point: runs every benchmark and prints JSON results
+ */
+int main(int argc, char *argv[]) {
+  size_t reps = 21;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--reps=", 0) == 0) {
+      reps = std::stoul(arg.substr(7));
+    } else if (arg.rfind("--filter=", 0) == 0) {
+      filter = arg.substr(9);
+    } else {
+      std::cerr << "Usage: bench_micro [--reps=N] [--filter=SUBSTRING]\n";
+      return 1;
+    }
+  }
+  if (reps == 0) {
+    reps = 1;
+  }
+
+  BenchRunner bench(reps, filter);
+  constexpr size_t N = 4096; // Operations per timed batch (and input count)
+  const auto lines = make_lines(N, 10);
+
+  CLIConfig config;
+  config.output_sma = config.output_ema = true;
+  config.output_vol = config.output_vwap = true;
+
+  // ---- Parsing ----
+  {
+    CSVAnalyzer analyzer(config);
+    bench.run("split_csv_line", N, [&](size_t i) {
+      do_not_optimize(analyzer.split_csv_line(lines[i]));
+    });
+    bench.run("parse_line", N, [&](size_t i) {
+      do_not_optimize(analyzer.parse_line(lines[i]));
+    });
+
+    std::vector<std::array<FieldRange, 5>> fields;
+    for (const auto &line : lines) {
+      fields.push_back(analyzer.split_csv_line(line));
+    }
+    bench.run("parse_price", N, [&](size_t i) {
+      double price;
+      do_not_optimize(parse_price(fields[i][2], price));
+      do_not_optimize(price);
+    });
+    bench.run("parse_volume", N, [&](size_t i) {
+      long volume;
+      do_not_optimize(parse_volume(fields[i][3], volume));
+      do_not_optimize(volume);
+    });
+    bench.run("parse_timestamp_ns", N, [&](size_t i) {
+      int64_t ts;
+      std::string_view text(fields[i][0].start, fields[i][0].length);
+      do_not_optimize(parse_timestamp_ns(text, ts));
+      do_not_optimize(ts);
+    });
+  }
+
+  // ---- Symbol lookup ----
+  for (size_t symbols : {10, 10000}) {
+    CSVAnalyzer analyzer(config);
+    std::vector<std::string> names(N);
+    for (size_t i = 0; i < N; ++i) {
+      names[i] = "SYM" + std::to_string((i * 2654435761u) % symbols);
+    }
+    for (size_t s = 0; s < symbols; ++s) {
+      analyzer.get_or_create_series("SYM" + std::to_string(s));
+    }
+    bench.run("get_or_create_series/" + std::to_string(symbols), N,
+              [&](size_t i) {
+                do_not_optimize(&analyzer.get_or_create_series(names[i]));
+              });
+  }
+
+  // ---- Indicators ----
+  std::vector<double> prices(N);
+  std::vector<long> volumes(N);
+  {
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> step(0.0, 0.001);
+    double price = 100.0;
+    for (size_t i = 0; i < N; ++i) {
+      price *= 1.0 + step(rng);
+      prices[i] = price;
+      volumes[i] = 100 + static_cast<long>(rng() % 5000);
+    }
+  }
+  const std::string ts = "2023-09-15 10:00:00";
+
+  SMAIndicator sma(20);
+  bench.run("SMAIndicator::update", N,
+            [&](size_t i) { sma.update(prices[i]); });
+  bench.run("SMAIndicator::get_value", N,
+            [&](size_t) { do_not_optimize(sma.get_value()); });
+
+  EMAIndicator ema(span_to_alpha(50));
+  bench.run("EMAIndicator::update", N,
+            [&](size_t i) { ema.update(prices[i]); });
+  bench.run("EMAIndicator::get_value", N,
+            [&](size_t) { do_not_optimize(ema.get_value()); });
+
+  VolatilityIndicator vol(30);
+  bench.run("VolatilityIndicator::update", N,
+            [&](size_t i) { vol.update(prices[i] / 100.0 - 1.0); });
+  bench.run("VolatilityIndicator::get_value", N,
+            [&](size_t) { do_not_optimize(vol.get_value()); });
+
+  VWAPIndicator vwap;
+  bench.run("VWAPIndicator::update", N,
+            [&](size_t i) { vwap.update(prices[i], volumes[i], ts); });
+  bench.run("VWAPIndicator::get_value", N,
+            [&](size_t) { do_not_optimize(vwap.get_value()); });
+
+  Series series(20, span_to_alpha(50), 30);
+  bench.run("Series::update", N, [&](size_t i) {
+    series.update(prices[i], volumes[i], ts);
+  });
+  bench.run("Series::update+get_indicator", N, [&](size_t i) {
+    series.update(prices[i], volumes[i], ts);
+    do_not_optimize(series.get_indicator(IndicatorType::SMA));
+    do_not_optimize(series.get_indicator(IndicatorType::EMA));
+    do_not_optimize(series.get_indicator(IndicatorType::VOLATILITY));
+    do_not_optimize(series.get_indicator(IndicatorType::VWAP));
+  });
+
+  // Batch form with every output wanted; reported per row, not per call
+  {
+    constexpr size_t ROWS = 256;
+    std::vector<int64_t> volumes64(volumes.begin(), volumes.end());
+    std::vector<int64_t> times(N);
+    int64_t ts_ns = 0;
+    parse_timestamp_ns(ts, ts_ns);
+    std::fill(times.begin(), times.end(), ts_ns);
+    std::vector<double> values(4 * ROWS);
+    const std::span<double> all(values);
+    const OutputSpans out{all.subspan(0, ROWS), all.subspan(ROWS, ROWS),
+                          all.subspan(2 * ROWS, ROWS),
+                          all.subspan(3 * ROWS, ROWS)};
+    Series batch_series(20, span_to_alpha(50), 30);
+    bench.run("Series::update_batch/" + std::to_string(ROWS), N,
+              [&](size_t i) {
+                if (i % ROWS == 0) {
+                  const size_t n = std::min(ROWS, N - i);
+                  batch_series.update_batch(
+                      std::span<const double>(prices).subspan(i, n),
+                      std::span<const int64_t>(volumes64).subspan(i, n),
+                      std::span<const int64_t>(times).subspan(i, n),
+                      out.subspan(0, n));
+                  do_not_optimize(values.data());
+                }
+              });
+  }
+
+  // ---- Output sinks (per row, in batches like the pipeline's) ----
+  {
+    CSVAnalyzer analyzer(config);
+    std::vector<ParsedRow> rows;
+    for (const auto &line : lines) {
+      rows.push_back(analyzer.parse_line(line));
+    }
+    std::vector<std::string_view> symbols;
+    std::vector<uint32_t> symbol_ids(N);
+    std::vector<std::string_view> timestamps(N);
+    std::vector<double> row_prices(N);
+    std::vector<int64_t> row_volumes(N);
+    for (size_t i = 0; i < N; ++i) {
+      const ParsedRow &row = rows[i];
+      auto known = std::find(symbols.begin(), symbols.end(), row.symbol);
+      symbol_ids[i] = static_cast<uint32_t>(known - symbols.begin());
+      if (known == symbols.end()) {
+        symbols.push_back(row.symbol);
+      }
+      timestamps[i] = row.timestamp;
+      row_prices[i] = row.price;
+      row_volumes[i] = row.volume;
+    }
+    std::vector<double> indicator(N, series.get_indicator(IndicatorType::SMA));
+
+    constexpr size_t ROWS = 4096;
+    auto run_sink = [&](const std::string &name, ResultSink &sink) {
+      bench.run(name, N, [&](size_t i) {
+        if (i % ROWS == 0) {
+          const size_t n = std::min(ROWS, N - i);
+          const std::span<const double> values(indicator.data() + i, n);
+          sink.write({n,
+                      std::span(timestamps).subspan(i, n),
+                      std::span(symbol_ids).subspan(i, n),
+                      symbols,
+                      std::span(row_prices).subspan(i, n),
+                      std::span(row_volumes).subspan(i, n),
+                      values, values, values, values, {}});
+          sink.commit(false);
+        }
+      });
+    };
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    CsvSink csv(null_stream);
+    run_sink("CsvSink::write", csv);
+    BinarySink binary(null_stream);
+    run_sink("BinarySink::write", binary);
+  }
+
+  bench.write_json(std::cout);
+  return 0;
+}
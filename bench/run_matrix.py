@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""End-to-end benchmark matrix for the analyzer.
+
+Runs ./analyzer over every combination of row count, symbol count and
+indicator set, recording rows/s, MB/s, peak RSS and cycles per row (from
+--profile) as JSON. With --baseline, results are compared against an earlier
+run and any regression beyond --threshold makes the script exit non-zero.
+
+Input files come from the C++ generator (tests/generate_test_data.cpp) and
+are cached under tests/data/bench/, so each size is generated only once.
+
+Usage:
+    python3 bench/run_matrix.py --rows=1M,10M --symbols=10,1k,100k \
+        --output=bench/results.json
+    python3 bench/run_matrix.py --baseline=bench/results.json --threshold=0.1
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+INDICATOR_SETS = {
+    "sma": ["--sma=20"],
+    "all": ["--sma=20", "--ema=50", "--vol=30", "--vwap=daily"],
+}
+
+# Metrics compared against the baseline: name -> True if higher is better
+METRICS = {
+    "rows_per_s": True,
+    "mb_per_s": True,
+    "peak_rss_mb": False,
+    "cycles_per_row": False,
+}
+
+
+def parse_count(text):
+    """Parses counts like "100k", "10M" or "1000"."""
+    multipliers = {"k": 1_000, "m": 1_000_000, "g": 1_000_000_000}
+    text = text.strip().lower()
+    if text and text[-1] in multipliers:
+        return int(float(text[:-1]) * multipliers[text[-1]])
+    return int(text)
+
+
+def format_count(value):
+    """Formats a count the way it is usually written (10k, 1M)."""
+    for suffix, size in (("G", 1_000_000_000), ("M", 1_000_000), ("k", 1_000)):
+        if value >= size and value % size == 0:
+            return f"{value // size}{suffix}"
+    return str(value)
+
+
+def ensure_input(generator, data_dir, rows, symbols, seed):
+    """Generates (once) the input file for a matrix cell and returns its path."""
+    path = os.path.join(
+        data_dir, f"rows{format_count(rows)}_sym{format_count(symbols)}.csv"
+    )
+    if not os.path.exists(path):
+        print(f"Generating {path}...", file=sys.stderr)
+        os.makedirs(data_dir, exist_ok=True)
+        subprocess.run(
+            [
+                generator,
+                f"--rows={rows}",
+                f"--symbols={symbols}",
+                f"--seed={seed}",
+                f"--output={path}.tmp",
+            ],
+            check=True,
+        )
+        os.replace(f"{path}.tmp", path)
+    return path
+
+
+def run_once(analyzer, flags, path):
+    """Runs the analyzer once; returns (seconds, peak RSS in MB, cycles/row)."""
+    with open(os.devnull, "wb") as devnull:
+        start = time.perf_counter()
+        process = subprocess.Popen(
+            [analyzer, *flags, "--profile", path],
+            stdout=devnull,
+            stderr=subprocess.PIPE,
+        )
+        stderr = process.stderr.read().decode()
+        _, status, usage = os.wait4(process.pid, 0)
+        seconds = time.perf_counter() - start
+
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise RuntimeError(f"analyzer failed on {path}:\n{stderr}")
+
+    cycles_per_row = None
+    for line in stderr.splitlines():
+        fields = line.split()
+        if len(fields) >= 3 and fields[0] == "[profile]" and fields[1] == "total":
+            cycles_per_row = float(fields[2])
+    # ru_maxrss is in kilobytes on Linux
+    return seconds, usage.ru_maxrss / 1024.0, cycles_per_row
+
+
+def run_matrix(args):
+    """Runs every matrix cell and returns the list of result records."""
+    results = []
+    for rows in args.rows:
+        for symbols in args.symbols:
+            path = ensure_input(
+                args.generator, args.data_dir, rows, symbols, args.seed
+            )
+            size_mb = os.path.getsize(path) / 1e6
+            for indicators in args.indicators:
+                name = (
+                    f"rows={format_count(rows)},symbols={format_count(symbols)},"
+                    f"indicators={indicators}"
+                )
+                runs = [
+                    run_once(args.analyzer, INDICATOR_SETS[indicators], path)
+                    for _ in range(args.reps)
+                ]
+                seconds = statistics.median(r[0] for r in runs)
+                cycles = [r[2] for r in runs if r[2] is not None]
+                record = {
+                    "name": name,
+                    "rows": rows,
+                    "symbols": symbols,
+                    "indicators": indicators,
+                    "reps": args.reps,
+                    "seconds": seconds,
+                    "rows_per_s": rows / seconds,
+                    "mb_per_s": size_mb / seconds,
+                    "peak_rss_mb": max(r[1] for r in runs),
+                    "cycles_per_row": statistics.median(cycles) if cycles else None,
+                }
+                print(
+                    f"{name}: {record['rows_per_s'] / 1e6:.2f} Mrows/s, "
+                    f"{record['mb_per_s']:.1f} MB/s, "
+                    f"{record['peak_rss_mb']:.1f} MB RSS",
+                    file=sys.stderr,
+                )
+                results.append(record)
+    return results
+
+
+def compare(results, baseline, threshold):
+    """Returns a list of regression messages against a baseline run."""
+    previous = {r["name"]: r for r in baseline.get("results", [])}
+    regressions = []
+    for record in results:
+        old = previous.get(record["name"])
+        if old is None:
+            continue
+        for metric, higher_is_better in METRICS.items():
+            new_value, old_value = record.get(metric), old.get(metric)
+            if not new_value or not old_value:
+                continue
+            change = (new_value - old_value) / old_value
+            if (higher_is_better and change < -threshold) or (
+                not higher_is_better and change > threshold
+            ):
+                regressions.append(
+                    f"{record['name']}: {metric} {old_value:.4g} -> "
+                    f"{new_value:.4g} ({change:+.1%})"
+                )
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--rows", default="1M,10M", help="e.g. 1M,10M,100M")
+    parser.add_argument("--symbols", default="10,1k,100k", help="e.g. 10,1k")
+    parser.add_argument(
+        "--indicators",
+        default=",".join(INDICATOR_SETS),
+        help=f"comma-separated subset of {sorted(INDICATOR_SETS)}",
+    )
+    parser.add_argument("--reps", type=int, default=3, help="runs per cell")
+    parser.add_argument("--seed", type=int, default=42, help="generator seed")
+    parser.add_argument("--analyzer", default="./analyzer")
+    parser.add_argument("--generator", default="./generate_test_data")
+    parser.add_argument("--data-dir", default="tests/data/bench")
+    parser.add_argument("--output", help="write results JSON here")
+    parser.add_argument("--baseline", help="results JSON to compare against")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="relative change that counts as a regression",
+    )
+    args = parser.parse_args()
+
+    args.rows = [parse_count(v) for v in args.rows.split(",")]
+    args.symbols = [parse_count(v) for v in args.symbols.split(",")]
+    args.indicators = args.indicators.split(",")
+    for indicators in args.indicators:
+        if indicators not in INDICATOR_SETS:
+            parser.error(f"unknown indicator set '{indicators}'")
+
+    results = run_matrix(args)
+    document = {
+        "units": {
+            "rows_per_s": "rows/s",
+            "mb_per_s": "MB/s",
+            "peak_rss_mb": "MB",
+            "cycles_per_row": "TSC cycles",
+        },
+        "results": results,
+    }
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(document, f, indent=2)
+            f.write("\n")
+    else:
+        json.dump(document, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(results, json.load(f), args.threshold)
+        for message in regressions:
+            print(f"REGRESSION {message}", file=sys.stderr)
+        if regressions:
+            return 1
+        print("No regressions against baseline", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,1418 @@
+#ifndef ANALYZER_HPP
+#define ANALYZER_HPP
+
+#include "bars.hpp"
+#include "corrections.hpp"
+#include "csv.hpp"
+#include "indicators.hpp"
+#include "latency.hpp"
+#include "probes.hpp"
+#include "profile.hpp"
+#include "progress.hpp"
+#include "reorder.hpp"
+#include "sink.hpp"
+#include "snapshot_index.hpp"
+#include "summary.hpp"
+#include "synthetic.hpp"
+#include "trace.hpp"
+#include "xsection.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct RowTiming
+ * @brief Latency timestamps a row carries through the pipeline (--latency)
+ */
+struct RowTiming {
+  uint64_t available_ns = 0; ///< When the row's line was read
+  uint64_t parsed_ns = 0;    ///< When the row's batch finished parsing
+  uint64_t released_ns = 0;  ///< When it left its reorder buffer (or parsed)
+  bool held = false;         ///< true if it went through a reorder buffer
+};
+
+/**
+ * @struct OutputRow
+ * @brief A row waiting to be formatted, with the indicator values captured
+ * right after its update
+ */
+struct OutputRow {
+  const ParsedRow *row = nullptr; ///< The row (owned by the current batch)
+  uint32_t symbol_id = 0;         ///< The row's symbol in the symbol table
+  double sma = 0;                 ///< SMA after the row (if output)
+  double ema = 0;                 ///< EMA after the row (if output)
+  double volatility = 0;          ///< Volatility after the row (if output)
+  double vwap = 0;                ///< VWAP after the row (if output)
+  double zscore = 0;              ///< Pair z-score (pair rows, if output)
+  RowTiming timing;               ///< Latency timestamps (--latency only)
+};
+
+/**
+ * @struct OutputColumns
+ * @brief Output rows of a batch regrouped column by column for the sink
+ *
+ * Reused across batches like InputBatch, so steady-state batches do not
+ * allocate.
+ */
+struct OutputColumns {
+  std::vector<std::string_view> timestamps; ///< Timestamp text of each row
+  std::vector<uint32_t> symbol_ids;         ///< Symbol id of each row
+  std::vector<double> prices;               ///< Price of each row
+  std::vector<int64_t> volumes;             ///< Volume of each row
+  std::vector<double> sma;                  ///< SMA of each row
+  std::vector<double> ema;                  ///< EMA of each row
+  std::vector<double> volatility;           ///< Volatility of each row
+  std::vector<double> vwap;                 ///< VWAP of each row
+  std::vector<double> zscore;               ///< Pair z-score of each row
+
+  /**
+   * @brief Copies the output rows into the columns
+   * @param rows Rows in output order
+   * @param columns Indicator columns to fill
+   */
+  void fill(const std::vector<OutputRow> &rows, const ResultColumns &columns) {
+    const size_t n = rows.size();
+    timestamps.resize(n);
+    symbol_ids.resize(n);
+    prices.resize(n);
+    volumes.resize(n);
+    sma.resize(columns.sma ? n : 0);
+    ema.resize(columns.ema ? n : 0);
+    volatility.resize(columns.volatility ? n : 0);
+    vwap.resize(columns.vwap ? n : 0);
+    zscore.resize(columns.zscore ? n : 0);
+    for (size_t i = 0; i < n; ++i) {
+      const OutputRow &out = rows[i];
+      timestamps[i] = out.row->timestamp;
+      symbol_ids[i] = out.symbol_id;
+      prices[i] = out.row->price;
+      volumes[i] = out.row->volume;
+      if (columns.sma) {
+        sma[i] = out.sma;
+      }
+      if (columns.ema) {
+        ema[i] = out.ema;
+      }
+      if (columns.volatility) {
+        volatility[i] = out.volatility;
+      }
+      if (columns.vwap) {
+        vwap[i] = out.vwap;
+      }
+      if (columns.zscore) {
+        zscore[i] = out.zscore;
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the filled columns as a sink batch
+   * @param symbols Symbol names by id
+   */
+  ResultBatch view(std::span<const std::string_view> symbols) const {
+    return {prices.size(), timestamps, symbol_ids, symbols, prices, volumes,
+            sma,           ema,        volatility, vwap,   zscore};
+  }
+};
+
+/**
+ * @struct SymbolState
+ * @brief A symbol's indicator series and its id in the output symbol table
+ */
+struct SymbolState {
+  Series series; ///< The symbol's indicators
+  uint32_t id;   ///< Index of the symbol's name in the symbol table
+  std::vector<BasketLeg> baskets; ///< Baskets the symbol is in (--basket)
+  std::vector<PairLeg> pairs;     ///< Pairs the symbol is a leg of (--pair)
+};
+
+/**
+ * @struct InputBatch
+ * @brief Lines read together and the per-stage results computed for them
+ *
+ * Every vector holds BATCH_ROWS slots allocated once and reused, so batches
+ * in steady state do not reallocate. Only the first `size` slots are live.
+ *
+ * Lines, offsets, fields and rows are produced by reading and parsing and
+ * are only read afterwards, so one parsed batch can feed several analyzers
+ * (--config-file). The remaining vectors hold each consumer's own lookups.
+ */
+struct InputBatch {
+  static constexpr size_t BATCH_ROWS = 4096; ///< Maximum lines per batch
+
+  size_t size = 0;                    ///< Non-empty lines in the batch
+  bool drained = false;               ///< true if no more input was buffered
+  std::vector<std::string> lines;     ///< Raw lines
+  std::vector<uint64_t> end_offsets;  ///< Byte offset just past each line
+  std::vector<uint64_t> available_ns; ///< When each line was read (--latency)
+  std::vector<std::array<FieldRange, 5>> fields; ///< Split fields
+  std::vector<ParsedRow> rows;                   ///< Parsed rows
+  std::vector<uint8_t> accepted; ///< Valid and selected by the symbol filter
+  std::vector<int64_t> ts_ns;    ///< Parsed timestamps (--max-lateness only)
+  std::vector<uint8_t> timed;    ///< Timestamp parsed (--max-lateness only)
+  std::vector<SymbolState *> symbols; ///< Each in-order trade's symbol
+
+  /**
+   * @brief Allocates every slot (idempotent)
+   */
+  void allocate() {
+    lines.resize(BATCH_ROWS);
+    end_offsets.resize(BATCH_ROWS);
+    available_ns.resize(BATCH_ROWS);
+    fields.resize(BATCH_ROWS);
+    rows.resize(BATCH_ROWS);
+    accepted.resize(BATCH_ROWS);
+    ts_ns.resize(BATCH_ROWS);
+    timed.resize(BATCH_ROWS);
+    symbols.resize(BATCH_ROWS);
+  }
+};
+
+/**
+ * @class CSVAnalyzer
+ * @brief Main application class for parsing and analyzing financial CSV data
+ *
+ * This class orchestrates the entire analysis pipeline:
+ * 1. Reads CSV files line by line
+ * 2. Parses each line into structured data
+ * 3. Maintains separate indicator series for each symbol
+ * 4. Outputs results in CSV format with selected indicators
+ *
+ * The analyzer supports filtering by symbol and selective output of indicators
+ * based on command-line configuration.
+ */
+class CSVAnalyzer {
+private:
+  // ========== Member Variables ==========
+
+  CLIConfig
+      config; ///< Command-line configuration controlling analysis behavior
+
+  /**
+   * @brief Map of symbol names to their corresponding indicator series
+   *
+   * Each unique symbol gets its own Series object that maintains independent
+   * indicator state. This allows simultaneous analysis of multiple symbols
+   * in a single pass through the data.
+   */
+  std::unordered_map<std::string, SymbolState> symbol_data;
+  std::vector<std::string_view> symbol_names; ///< Symbol table: keys of
+                                              ///< symbol_data by id
+
+  ParseStats stats; ///< Statistics tracking parsing success/failure
+
+  ProgressCounters progress; ///< Counters shown by --progress
+  uint64_t input_size = 0;   ///< Input size in bytes, or 0 if unknown
+
+  LatencyRecorder latency;          ///< Per-row latency histograms (--latency)
+  uint64_t next_latency_report = 0; ///< Deadline of next periodic report
+
+  /**
+   * @brief Rows held for reordering (only used with --max-lateness)
+   *
+   * Kept separate from symbol_data so the common in-order path pays nothing
+   * for reordering support.
+   */
+  ReorderBuffer reorder_buffer;
+  uint64_t arrival_seq = 0;  ///< Arrival counter for stable reordering
+  size_t late_rows = 0;      ///< Ticks rejected as later than --max-lateness
+  size_t untimed_rows = 0;   ///< Rows without a timestamp to order them by
+  std::ofstream late_output; ///< Destination for late ticks (--late-output)
+  std::ostream *diagnostics = &std::cerr; ///< Where warnings go
+
+  /**
+   * @brief Per-symbol trade journals and checkpoints (only with --corrections)
+   */
+  std::unordered_map<std::string, CorrectionLog> correction_logs;
+  size_t corrections_unmatched = 0; ///< Corrections whose trade was not found
+  size_t corrections_ignored = 0;   ///< Corrections seen without --corrections
+
+  SnapshotIndexWriter index_writer; ///< Snapshot writer (--build-index)
+  uint64_t input_offset = 0; ///< Byte offset just past the last line read
+
+  InputBatch batch; ///< Lines currently moving through the pipeline
+  std::vector<OutputRow> pending_output; ///< Rows updated but not yet written
+  std::deque<ParsedRow> released_rows;   ///< Rows released from reorder
+                                         ///< buffers, awaiting output
+  ResultColumns result_columns; ///< Indicator columns that are output
+  OutputColumns output_columns; ///< Output rows of the batch, by column
+  std::unique_ptr<ResultSink> owned_sink; ///< Sink selected by --output
+  ResultSink *sink;         ///< Where output rows go (owned_sink by default)
+  std::unique_ptr<CrossSection> xsection; ///< Replaces rows (--xsection)
+  std::unique_ptr<SummaryReport> summary; ///< Replaces rows (--summary)
+  std::unique_ptr<BarSampler> bars;       ///< Replaces rows (--bars)
+
+  /**
+   * @brief Synthetic basket and pair symbols (only with --basket / --pair)
+   *
+   * A trade reaches its baskets and pairs through the fan-out lists in its
+   * SymbolState, so symbols outside every basket and pair pay nothing.
+   */
+  std::vector<Basket> baskets;
+  std::vector<SymbolState *> basket_symbols; ///< By basket, once valued
+  std::unordered_map<std::string, std::vector<BasketLeg>> legs_by_symbol;
+  std::vector<PairSeries> pairs;
+  std::vector<SymbolState *> pair_symbols; ///< By pair, once valued
+  std::unordered_map<std::string, std::vector<PairLeg>> pairs_by_symbol;
+  std::deque<ParsedRow> synthetic_rows; ///< Rows of synthetic symbols,
+                                        ///< reused across batches
+  size_t synthetic_used = 0; ///< Live rows of synthetic_rows
+  std::string partial_line; ///< Incomplete last line of pushed input
+  StageProfiler profiler;    ///< Per-stage clock ticks (--profile)
+
+  TraceRecorder trace;                 ///< Stage timelines (--trace)
+  TraceBuffer *trace_buffer = nullptr; ///< This thread's buffer, if tracing
+  uint64_t trace_mark = 0;    ///< When the current stage started (--trace)
+  uint64_t batch_number = 0;  ///< Batches read so far
+  std::ofstream trace_output; ///< Destination of the trace (--trace)
+
+public:
+  /**
+   * @brief Constructs a CSVAnalyzer with the given configuration
+   * @param cli_config Configuration object containing analysis parameters and
+   * output flags
+   * @param destination Where rows, cross-sections and summaries are written
+   * (unless set_sink() replaces the sink)
+   */
+  CSVAnalyzer(const CLIConfig &cli_config,
+              std::ostream &destination = std::cout)
+      : config(cli_config),
+        result_columns(ResultColumns::from_config(cli_config)),
+        owned_sink(make_result_sink(cli_config.xsection_ns > 0 ||
+                                            cli_config.summary ||
+                                            !cli_config.bar_kind.empty()
+                                        ? "null"
+                                        : cli_config.output_format,
+                                    destination)),
+        sink(owned_sink.get()), baskets(load_baskets(cli_config.baskets)),
+        basket_symbols(baskets.size()), legs_by_symbol(basket_legs(baskets)),
+        pairs(load_pairs(cli_config.pairs, cli_config.pair_window, baskets)),
+        pair_symbols(pairs.size()), pairs_by_symbol(pair_legs(pairs)) {
+    if (cli_config.xsection_ns > 0) {
+      xsection = std::make_unique<CrossSection>(
+          cli_config.xsection_ns, cli_config.xsection_universe,
+          result_columns, destination);
+    }
+    if (cli_config.summary) {
+      summary = std::make_unique<SummaryReport>(result_columns, destination);
+    }
+    if (!cli_config.bar_kind.empty()) {
+      const BarKind kind = cli_config.bar_kind == "volume"   ? BarKind::VOLUME
+                           : cli_config.bar_kind == "dollar" ? BarKind::DOLLAR
+                                                             : BarKind::TICKS;
+      bars = std::make_unique<BarSampler>(kind, cli_config.bar_threshold,
+                                          result_columns, destination);
+    }
+  }
+
+  /**
+   * @brief Splits a CSV line into its fields without string allocation
+   * @param line The CSV line to split (expected format:
+   * "timestamp,symbol,price,volume[,action]")
+   * @return Array of 5 FieldRange objects pointing to substrings within the
+   * original line; fields that are not present have length 0, and the last
+   * one holds the rest of the line after the fourth comma
+   *
+   * This function uses pointer arithmetic to avoid string copying, making
+   * parsing more efficient for large files. Each FieldRange contains a pointer
+   * to the start of the field and its length.
+   *
+   * Expected CSV format: "2024-01-15 09:30:00,AAPL,150.25,1000000"
+   * Fields: [0]=timestamp, [1]=symbol, [2]=price, [3]=volume, [4]=action
+   */
+  std::array<FieldRange, 5> split_csv_line(const std::string &line) {
+    const char *data = line.data();
+    std::array<FieldRange, 5> fields = {}; // Initialize all fields to zeros
+    int field_index = 0;
+    size_t start = 0;
+
+    // Iterate through the line, splitting on commas
+    for (size_t i = 0; i <= line.length() && field_index < 5; ++i) {
+      // Found delimiter or end of line; the action field runs to the end
+      if (i == line.length() || (line[i] == ',' && field_index < 4)) {
+        // Record the field's position and length
+        fields[field_index] = {data + start, i - start};
+        field_index++;
+        start = i + 1; // Start of next field is after the comma
+      }
+    }
+
+    return fields;
+  }
+
+  /**
+   * @brief Parses a CSV line into a structured ParsedRow object
+   * @param line The CSV line to parse
+   * @return ParsedRow containing parsed data with is_valid flag set
+   * appropriately
+   *
+   * Splits the line with split_csv_line() and converts the fields with
+   * parse_fields().
+   */
+  ParsedRow parse_line(const std::string &line) {
+    return parse_fields(split_csv_line(line));
+  }
+
+  /**
+   * @brief Converts the fields of a split line into a ParsedRow object
+   * @param fields Fields returned by split_csv_line()
+   * @return ParsedRow containing parsed data with is_valid flag set
+   * appropriately
+   *
+   * This function performs the conversion steps of the parsing pipeline:
+   * 1. Validates field count
+   * 2. Extracts timestamp and symbol as strings
+   * 3. Parses price as a double using strtod (faster than std::stod)
+   * 4. Parses volume as a long using std::from_chars
+   * 5. Reads the optional action column: the rest of the line is "X"
+   *    (cancel) or "A" (amend); anything else there is ignored, as any
+   *    extra columns always were
+   *
+   * Returns ParsedRow::invalid() if:
+   * - Line doesn't have the 4 required fields
+   * - Price field cannot be parsed as a valid double
+   * - Volume field cannot be parsed as a valid long integer
+   *
+   * Performance note: Uses strtod and from_chars to avoid string allocation
+   * overhead
+   */
+  ParsedRow parse_fields(const std::array<FieldRange, 5> &fields) {
+    // Validate we have all expected fields
+    if (fields[3].start == nullptr) {
+      return ParsedRow::invalid();
+    }
+
+    // Extract timestamp and symbol (fields 0 and 1)
+    std::string timestamp(fields[0].start, fields[0].length);
+    std::string symbol(fields[1].start, fields[1].length);
+
+    // Parse price (field 2) and volume (field 3) without allocating
+    double price;
+    long volume;
+    if (!parse_price(fields[2], price) || !parse_volume(fields[3], volume)) {
+      return ParsedRow::invalid();
+    }
+
+    // Optional action column (field 4): anything but "X" or "A" is a trade
+    RowAction action = RowAction::TRADE;
+    if (fields[4].length == 1 && fields[4].start[0] == 'X') {
+      action = RowAction::CANCEL;
+    } else if (fields[4].length == 1 && fields[4].start[0] == 'A') {
+      action = RowAction::AMEND;
+    }
+
+    // All fields parsed successfully
+    return {timestamp, symbol, price, volume, true, action};
+  }
+
+  /**
+   * @brief Retrieves or creates a Series object for the given symbol
+   * @param symbol Stock symbol (e.g., "AAPL", "GOOGL")
+   * @return Reference to the Series object for this symbol
+   *
+   * This function implements lazy initialization: Series objects are only
+   * created when first needed for a symbol. All Series are created with the
+   * same indicator parameters from the configuration.
+   *
+   * The EMA alpha value is calculated from the configured span using the
+   * formula: alpha = 2 / (span + 1)
+   */
+  Series &get_or_create_series(const std::string &symbol) {
+    return get_or_create_symbol(symbol).series;
+  }
+
+  /**
+   * @brief Retrieves or creates a symbol's Series together with its id
+   *
+   * New symbols get the next id and their name is appended to the symbol
+   * table that output sinks receive.
+   */
+  SymbolState &get_or_create_symbol(const std::string &symbol) {
+    // Check if we already have a Series for this symbol
+    auto found = symbol_data.find(symbol);
+    if (found == symbol_data.end()) {
+      // Create new Series with configured parameters
+      double ema_alpha = span_to_alpha(config.ema_span);
+      found = symbol_data
+                  .emplace(symbol,
+                           SymbolState{Series(config.sma_window, ema_alpha,
+                                              config.vol_window),
+                                       static_cast<uint32_t>(
+                                           symbol_names.size()),
+                                       {},
+                                       {}})
+                  .first;
+      symbol_names.push_back(found->first);
+      if (auto legs = legs_by_symbol.find(symbol);
+          legs != legs_by_symbol.end()) {
+        found->second.baskets = legs->second;
+      }
+      if (auto legs = pairs_by_symbol.find(symbol);
+          legs != pairs_by_symbol.end()) {
+        found->second.pairs = legs->second;
+      }
+      ANALYZER_PROBE2(symbol_created, symbol.c_str(), symbol_data.size());
+    }
+    return found->second;
+  }
+
+  /**
+   * @brief Processes a CSV file and outputs results with computed indicators
+   * @param filename Path to the CSV file to process, or "-" for standard input
+   * @return true if processing completed successfully, false if file cannot be
+   * opened
+   *
+   * Opens the input and delegates to process_stream(). Reading from standard
+   * input allows the analyzer to run on live data piped from a feed handler.
+   */
+  bool process_file(const std::string &filename) {
+    if (filename == "-") {
+      return process_stream(std::cin);
+    }
+
+    // Known sizes let --progress show a percentage and ETA
+    std::error_code error;
+    if (std::filesystem::is_regular_file(filename, error)) {
+      input_size = std::filesystem::file_size(filename, error);
+      if (error) {
+        input_size = 0;
+      }
+    }
+
+    std::ifstream file(filename);
+
+    // Validate file can be opened
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open file '" << filename << "'\n";
+      return false;
+    }
+
+    return process_stream(file);
+  }
+
+  /**
+   * @brief Processes CSV data from a stream and outputs results
+   * @param input Stream positioned at the first data line
+   * @return true once the stream has been fully consumed
+   *
+   * Processing pipeline, run on batches of up to InputBatch::BATCH_ROWS lines:
+   * 1. Starts the output sink (the CSV header, once)
+   * 2. Reads a batch of lines (skipping empty lines)
+   * 3. Splits every line into fields
+   * 4. Parses the fields (invalid rows are flagged and skipped later)
+   * 5. Applies symbol filtering and looks up each row's Series
+   * 6. Updates indicators row by row, capturing the values to output
+   * 7. Hands the batch's output rows to the sink, which writes them in one
+   * call
+   *
+   * The function is streaming: memory use is bounded by the batch size, not
+   * by the input, making it suitable for very large datasets and for
+   * unbounded live feeds. A batch ends early whenever the input has no more
+   * data buffered, so live rows are never held back waiting for a batch to
+   * fill.
+   *
+   * When latency reporting is enabled (--latency), each emitted row is timed
+   * from the moment its line was read to the moment it was written, broken
+   * down into parse, update and output stages. With --profile, the time spent
+   * in each stage is accumulated per batch and reported at exit.
+   */
+  bool process_stream(std::istream &input) {
+    if (!open_outputs()) {
+      return false;
+    }
+
+    if (!config.trace_filename.empty()) {
+      trace_output.open(config.trace_filename);
+      if (!trace_output.is_open()) {
+        std::cerr << "Error: Cannot open file '" << config.trace_filename
+                  << "'\n";
+        return false;
+      }
+      trace_buffer = &trace.local("pipeline");
+      trace_mark = trace_now_ns();
+    }
+
+    // Output the header (CSV) or stream preamble (binary)
+    begin_output();
+
+    const bool timed = config.report_latency;
+    if (timed && config.latency_interval_ns > 0) {
+      next_latency_report = latency_now_ns() + config.latency_interval_ns;
+    }
+    if (config.profile_stages) {
+      profiler.start(config.profile_hardware, std::cerr);
+    }
+    std::optional<ProgressReporter> progress_reporter;
+    if (config.progress_interval_ns > 0) {
+      progress_reporter.emplace(progress, input_size,
+                                config.progress_interval_ns, std::cerr,
+                                trace_buffer ? &trace : nullptr);
+    }
+
+    batch.allocate();
+    bool more = true;
+    while (more) {
+      batch_number++;
+      more = read_batch(input, batch);
+      ANALYZER_PROBE3(batch_read, batch.size, input_offset, batch.drained);
+      profile_lap(ProfileStage::READ);
+
+      process_batch();
+      profiler.count_batch(batch.size);
+      if (progress_reporter) {
+        publish_progress();
+      }
+    }
+
+    end_input();
+    if (progress_reporter) {
+      publish_progress();
+      progress_reporter.reset(); // Prints the final line
+    }
+    report_corrections();
+
+    if (timed) {
+      latency.report_total(std::cerr);
+    }
+    if (config.profile_stages) {
+      profiler.report(std::cerr);
+    }
+    if (trace_buffer) {
+      trace.write(trace_output);
+      trace_output.close();
+      if (!trace_output) {
+        std::cerr << "Error: Cannot write trace to '" << config.trace_filename
+                  << "'\n";
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Sends output rows to a sink instead of the one chosen by --output
+   * @param destination Receives every batch of output rows; must outlive
+   * the analyzer. Its begin() is not called here.
+   *
+   * Used when the analyzer is embedded (see Engine) rather than run as a
+   * command-line filter.
+   */
+  void set_sink(ResultSink &destination) { sink = &destination; }
+
+  /**
+   * @brief Sends warnings (late rows, unapplied corrections) to a stream
+   * instead of stderr
+   * @param destination Must outlive the analyzer
+   *
+   * Used by --config-file, whose jobs finish on their own threads: each
+   * collects its warnings, printed once every job has joined.
+   */
+  void set_diagnostics(std::ostream &destination) {
+    diagnostics = &destination;
+  }
+
+  /**
+   * @brief Opens the files the configuration writes besides the output
+   * @return false (after printing an error) if one cannot be created
+   *
+   * Covers --late-output and --build-index; call once before the first row.
+   */
+  bool open_outputs() {
+    if (!config.late_output_filename.empty()) {
+      late_output.open(config.late_output_filename);
+      if (!late_output.is_open()) {
+        std::cerr << "Error: Cannot open file '" << config.late_output_filename
+                  << "'\n";
+        return false;
+      }
+    }
+
+    if (!config.build_index_filename.empty() &&
+        !index_writer.open(config.build_index_filename, config)) {
+      std::cerr << "Error: Cannot create index '"
+                << config.build_index_filename << "'\n";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Processes a chunk of CSV input pushed by an embedding program
+   * @param bytes Any number of bytes; lines may be split across chunks
+   *
+   * Every complete line is processed before this returns, so the row
+   * callback has seen all of them; an unterminated last line is kept until
+   * more bytes or finish_push() arrive. No header is printed.
+   */
+  void push(std::string_view bytes) {
+    batch.allocate();
+    size_t start = 0;
+    while (start < bytes.size()) {
+      const size_t newline = bytes.find('\n', start);
+      if (newline == std::string_view::npos) {
+        partial_line.append(bytes.substr(start));
+        break;
+      }
+      partial_line.append(bytes.substr(start, newline - start));
+      start = newline + 1;
+      queue_pushed_line();
+    }
+    if (batch.size > 0) {
+      process_batch();
+      batch.size = 0;
+    }
+  }
+
+  /**
+   * @brief Ends pushed input: processes an unterminated last line and
+   * releases every row still held for reordering
+   */
+  void finish_push() {
+    batch.allocate();
+    if (!partial_line.empty()) {
+      queue_pushed_line();
+    }
+    if (batch.size > 0) {
+      process_batch();
+      batch.size = 0;
+    }
+    end_input();
+  }
+
+  /**
+   * @brief Prepares to consume batches parsed by another analyzer
+   * @return false (after printing an error) if an output file cannot be
+   * created
+   *
+   * Starts the sink and allocates this analyzer's per-row lookups; batches
+   * are then passed to consume_batch() and the input is ended by
+   * finish_shared(). Used by --config-file, where every job consumes the
+   * batches one reader parsed.
+   */
+  bool begin_shared() {
+    if (!open_outputs()) {
+      return false;
+    }
+    begin_output();
+    batch.allocate();
+    return true;
+  }
+
+  /**
+   * @brief Ends shared input: releases rows still held for reordering and
+   * reports corrections that could not be applied
+   */
+  void finish_shared() {
+    end_input();
+    report_corrections();
+  }
+
+  /**
+   * @brief Returns line and parse-failure counts so far
+   */
+  const ParseStats &parse_stats() const { return stats; }
+
+  /**
+   * @brief Reads the next batch of non-empty lines
+   * @param input Stream to read from
+   * @param batch Batch to fill (allocated)
+   * @return false once the stream is exhausted (the batch may still hold its
+   * final lines)
+   *
+   * A batch ends after InputBatch::BATCH_ROWS lines or as soon as the stream
+   * has no more data buffered, so a slow live feed is processed as it arrives
+   * instead of waiting for a batch to fill.
+   */
+  bool read_batch(std::istream &input, InputBatch &batch) {
+    std::streambuf *source = input.rdbuf();
+    const bool timed = config.report_latency;
+    batch.size = 0;
+    batch.drained = false;
+
+    while (batch.size < InputBatch::BATCH_ROWS) {
+      std::string &line = batch.lines[batch.size];
+      if (!std::getline(input, line)) {
+        batch.drained = true;
+        return false;
+      }
+      // Track where the next line starts (snapshot indexes seek to it)
+      input_offset += line.size() + 1;
+
+      // Skip empty lines
+      if (!line.empty()) {
+        batch.end_offsets[batch.size] = input_offset;
+        if (timed) {
+          // Bytes for this row are available from here on
+          batch.available_ns[batch.size] = latency_now_ns();
+        }
+        batch.size++;
+      }
+
+      if (source->in_avail() <= 0) {
+        batch.drained = true;
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Moves the completed partial_line into the batch
+   *
+   * Mirrors read_batch(): empty lines are skipped, and a full batch is
+   * processed immediately.
+   */
+  void queue_pushed_line() {
+    input_offset += partial_line.size() + 1;
+    if (!partial_line.empty()) {
+      batch.lines[batch.size].swap(partial_line);
+      batch.end_offsets[batch.size] = input_offset;
+      if (config.report_latency) {
+        batch.available_ns[batch.size] = latency_now_ns();
+      }
+      if (++batch.size == InputBatch::BATCH_ROWS) {
+        process_batch();
+        batch.size = 0;
+      }
+    }
+    partial_line.clear();
+  }
+
+  /**
+   * @brief Runs the lines of the current batch through every stage
+   *
+   * Splits and parses every line, applies the symbol filter and lookups,
+   * updates indicators and emits the output rows. Standard output is
+   * flushed if the input had nothing more buffered (batch.drained), so
+   * live consumers see rows as soon as they are computed.
+   */
+  void process_batch() {
+    parse_batch(batch);
+    consume_batch(batch,
+                  config.report_latency ? latency_now_ns() : 0);
+  }
+
+  /**
+   * @brief Splits and parses every line of a batch and counts the results
+   * @param in A batch filled by read_batch()
+   */
+  void parse_batch(InputBatch &in) {
+    for (size_t i = 0; i < in.size; ++i) {
+      in.fields[i] = split_csv_line(in.lines[i]);
+    }
+    profile_lap(ProfileStage::SPLIT);
+
+    size_t failures = 0;
+    for (size_t i = 0; i < in.size; ++i) {
+      ParsedRow &row = in.rows[i];
+      row = parse_fields(in.fields[i]);
+      failures += !row.is_valid;
+      if (row.is_valid) {
+        ANALYZER_PROBE3(row_parsed, row.symbol.c_str(), row.timestamp.c_str(),
+                        row.volume);
+      } else {
+        ANALYZER_PROBE3(row_rejected, in.lines[i].data(), in.lines[i].size(),
+                        in.end_offsets[i]);
+      }
+    }
+    stats.total_lines += in.size;
+    stats.parse_failures += failures;
+    stats.parsed_successfully += in.size - failures;
+    profile_lap(ProfileStage::PARSE);
+  }
+
+  /**
+   * @brief Runs a parsed batch through lookup, update and output
+   * @param in A batch processed by parse_batch(), possibly by another
+   * analyzer; it is not modified unless it is this analyzer's own batch
+   * @param t_parsed When the batch finished parsing (latency only)
+   */
+  void consume_batch(InputBatch &in, uint64_t t_parsed) {
+    if (!config.build_index_filename.empty()) {
+      // The index records which input its offsets point into
+      for (size_t i = 0; i < in.size; ++i) {
+        index_writer.consume(in.lines[i], in.end_offsets[i]);
+      }
+    }
+    resolve_batch(in);
+    profile_lap(ProfileStage::LOOKUP);
+
+    apply_batch(in, t_parsed);
+    profile_lap(ProfileStage::UPDATE);
+
+    write_output(config.report_latency ? latency_now_ns() : 0, in.drained);
+  }
+
+  /**
+   * @brief Applies the symbol filter and looks up each row's symbol state
+   * @param in The parsed batch
+   *
+   * In-order trades get their Series, rows of a reordered run their parsed
+   * timestamp. Correction rows are left to apply_correction(), which only
+   * touches symbols that already have a journal. Results go to this
+   * analyzer's own batch slots.
+   */
+  void resolve_batch(const InputBatch &in) {
+    for (size_t i = 0; i < in.size; ++i) {
+      const ParsedRow &row = in.rows[i];
+      batch.accepted[i] = false;
+      if (!row.is_valid)
+        continue; // Skip malformed lines
+
+      // If filter_symbol is set, only process matching symbols
+      if (!config.filter_symbol.empty() && row.symbol != config.filter_symbol)
+        continue;
+
+      if (config.reorder_ticks) {
+        // Rows without an orderable timestamp are set aside by reorder_row
+        batch.timed[i] = parse_timestamp_ns(row.timestamp, batch.ts_ns[i]);
+      } else if (row.action == RowAction::TRADE) {
+        batch.symbols[i] = &get_or_create_symbol(row.symbol);
+      }
+      batch.accepted[i] = true;
+    }
+  }
+
+  /**
+   * @brief Updates indicators for every accepted row of the batch, in order
+   * @param in The parsed batch
+   * @param t_parsed When the batch finished parsing (latency only)
+   */
+  void apply_batch(InputBatch &in, uint64_t t_parsed) {
+    for (size_t i = 0; i < in.size; ++i) {
+      if (!batch.accepted[i])
+        continue;
+
+      const ParsedRow &row = in.rows[i];
+      RowTiming timing{in.available_ns[i], t_parsed, t_parsed, false};
+      if (config.reorder_ticks) {
+        reorder_row(in, i, timing);
+      } else if (row.action != RowAction::TRADE) {
+        apply_correction(row);
+      } else {
+        apply_row(row, *batch.symbols[i], in.end_offsets[i], timing);
+      }
+    }
+  }
+
+  /**
+   * @brief Routes a row of the batch through the reorder buffer
+   * @param in The parsed batch
+   * @param i Index of the row in the batch
+   * @param timing The row's latency timestamps so far
+   *
+   * The buffer takes the row by move from this analyzer's own batch, and a
+   * copy from a batch shared with other analyzers.
+   */
+  void reorder_row(InputBatch &in, size_t i, const RowTiming &timing) {
+    ParsedRow &row = in.rows[i];
+    const int64_t ts_ns = batch.ts_ns[i];
+
+    // Without a timestamp the row cannot be placed in order: count it and
+    // route it aside with the late ticks
+    if (!batch.timed[i]) {
+      untimed_rows++;
+      set_aside(in.lines[i]);
+      return;
+    }
+
+    // Corrections bypass the buffer: fix the trade in place if it is still
+    // held, otherwise apply to the already released history
+    if (row.action != RowAction::TRADE) {
+      if (config.correction_checkpoint_interval == 0 ||
+          !reorder_buffer.correct(ts_ns, row)) {
+        apply_correction(row);
+      }
+      return;
+    }
+
+    if (!reorder_buffer.push({ts_ns, arrival_seq++, timing.available_ns,
+                      timing.parsed_ns,
+                      &in == &batch ? std::move(row) : ParsedRow(row)},
+                     config.max_lateness_ns)) {
+      // Too late to be placed in order: count it and route it aside
+      late_rows++;
+      set_aside(in.lines[i]);
+      return;
+    }
+
+    reorder_buffer.release(config.max_lateness_ns,
+                           [&](PendingRow &pending) { release_row(pending); });
+  }
+
+  /**
+   * @brief Writes a row that cannot be reordered to --late-output, if set
+   * @param line The row's raw text
+   */
+  void set_aside(const std::string &line) {
+    if (late_output.is_open()) {
+      late_output << line << '\n';
+    }
+  }
+
+  /**
+   * @brief Applies a row released from a reorder buffer
+   * @param pending The released row (its ParsedRow is moved out)
+   */
+  void release_row(PendingRow &pending) {
+    released_rows.push_back(std::move(pending.row));
+    const ParsedRow &row = released_rows.back();
+    RowTiming timing{pending.available_ns, pending.parsed_ns,
+                     config.report_latency ? latency_now_ns() : 0, true};
+    apply_row(row, get_or_create_symbol(row.symbol), input_offset, timing);
+  }
+
+  /**
+   * @brief Publishes the counters shown by --progress (once per batch)
+   */
+  void publish_progress() {
+    progress.bytes.store(input_offset, std::memory_order_relaxed);
+    progress.rows.store(stats.total_lines, std::memory_order_relaxed);
+    progress.failures.store(stats.parse_failures, std::memory_order_relaxed);
+    progress.symbols.store(symbol_data.size(), std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Charges the time since the previous lap to a stage (--profile)
+   *
+   * With --trace the same interval is also recorded as a span of the
+   * current batch on this thread's timeline.
+   */
+  void profile_lap(ProfileStage stage) {
+    if (config.profile_stages) {
+      profiler.lap(stage);
+    }
+    if (trace_buffer) {
+      const uint64_t now = trace_now_ns();
+      trace_buffer->record(profile_stage_name(stage), trace_mark, now,
+                           batch_number);
+      trace_mark = now;
+    }
+  }
+
+  /**
+   * @brief Answers an --as-of query from the snapshot index
+   * @return true if a row at or before the query time was found
+   * @throws std::runtime_error if the index or its snapshot cannot be read,
+   * or the index was built from another input
+   *
+   * Restores the symbol's latest snapshot taken at or before the query time,
+   * then replays only that symbol's rows from the snapshot's file offset
+   * until the first row past the query time. Prints the CSV header and one
+   * row: the last row of the symbol at or before the query time, with its
+   * indicator values. Both go through the --output sink.
+   */
+  bool process_as_of_query() {
+    const std::string &symbol = config.as_of_symbol;
+    int64_t query_ns = 0;
+    parse_timestamp_ns(config.as_of_timestamp, query_ns);
+
+    SymbolState &state = get_or_create_symbol(symbol);
+    Series &series = state.series;
+    ParsedRow last_row = ParsedRow::invalid();
+    uint64_t offset = 0;
+
+    std::ifstream file(config.input_filename);
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open file '" << config.input_filename
+                << "'\n";
+      return false;
+    }
+
+    SnapshotEntry snapshot;
+    if (find_snapshot(config.index_filename, config, input_identity(file),
+                      symbol, query_ns, snapshot)) {
+      std::istringstream state(snapshot.state);
+      if (!series.load(state)) {
+        throw std::runtime_error("Corrupt snapshot in index '" +
+                                 config.index_filename + "'");
+      }
+      offset = snapshot.offset;
+      last_row = snapshot.row;
+    }
+
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+
+    // Replay the gap between the snapshot and the query time; other
+    // symbols' lines are only split, not converted
+    std::string line;
+    while (std::getline(file, line)) {
+      const std::array<FieldRange, 5> fields = split_csv_line(line);
+      if (std::string_view(fields[1].start, fields[1].length) != symbol)
+        continue;
+      auto row = parse_fields(fields);
+      if (!row.is_valid || row.action != RowAction::TRADE)
+        continue;
+
+      int64_t ts_ns;
+      if (!parse_timestamp_ns(row.timestamp, ts_ns))
+        continue;
+      if (ts_ns > query_ns)
+        break;
+
+      series.update(row.price, row.volume, row.timestamp);
+      last_row = std::move(row);
+    }
+
+    if (!last_row.is_valid) {
+      std::cerr << "Error: No " << symbol << " rows at or before "
+                << config.as_of_timestamp << "\n";
+      return false;
+    }
+
+    sink->begin(result_columns);
+    pending_output.push_back(make_output_row(last_row, state));
+    write_output(0, true);
+    return true;
+  }
+
+  /**
+   * @brief Updates indicators for one trade and queues it for output
+   * @param row The parsed (and already filtered) trade
+   * @param state The symbol's Series and id
+   * @param next_offset Byte offset of the line following the row
+   * @param timing The row's latency timestamps so far
+   *
+   * The indicator values are captured immediately, so later rows of the same
+   * symbol in the batch cannot change what this row outputs. With
+   * --xsection or --summary the trade goes to them instead, and with --bars
+   * to the symbol's open bar.
+   */
+  void apply_row(const ParsedRow &row, SymbolState &state,
+                 uint64_t next_offset, const RowTiming &timing) {
+    Series &series = state.series;
+    if (bars) {
+      // Indicators run on bar closes instead of trades
+      bars->add(state.id, row.price, row.volume, [&](const Bar &bar) {
+        series.update(bar.close, bar.volume, row.timestamp);
+        bars->write(row.timestamp, symbol_names[state.id], bar, series);
+      });
+      return;
+    }
+    observe_row(row, state);
+    if (config.correction_checkpoint_interval != 0) {
+      // Journal the trade so later cancels/amends can find it
+      auto log = correction_logs
+                     .try_emplace(row.symbol,
+                                  config.correction_checkpoint_interval, series)
+                     .first;
+      series.update(row.price, row.volume, row.timestamp);
+      log->second.record(row, series);
+    } else {
+      series.update(row.price, row.volume, row.timestamp);
+    }
+    ANALYZER_PROBE3(indicator_updated, row.symbol.c_str(),
+                    row.timestamp.c_str(), row.volume);
+    if (!config.build_index_filename.empty()) {
+      index_writer.observe(row, series, next_offset);
+    }
+
+    if (outputs_rows()) {
+      pending_output.push_back(make_output_row(row, state, timing));
+    }
+    update_synthetics(state, row, timing);
+  }
+
+  /**
+   * @brief Hands a trade to the cross-section or the summary, which replace
+   * per-row output (--xsection, --summary)
+   *
+   * Called before the symbol's update, so a bucket the trade closes shows
+   * the indicators as of the bucket's end.
+   */
+  void observe_row(const ParsedRow &row, const SymbolState &state) {
+    int64_t ts_ns;
+    if (xsection && parse_timestamp_ns(row.timestamp, ts_ns)) {
+      xsection->observe(state.id, symbol_names[state.id], state.series, ts_ns,
+                        row.price);
+    }
+    if (summary) {
+      summary->observe(state.id, symbol_names[state.id], state.series,
+                       row.timestamp, row.price, row.volume);
+    }
+  }
+
+  /**
+   * @brief Returns true unless rows are replaced by a cross-section or a
+   * summary
+   */
+  bool outputs_rows() const { return !xsection && !summary; }
+
+  /**
+   * @brief Moves the baskets and pairs a symbol belongs to by its trade
+   * @param state The symbol that traded (possibly a basket)
+   * @param row The trade
+   * @param timing The trade's latency timestamps
+   *
+   * Synthetic rows carry the trade's timestamp and volume (so their VWAP
+   * weights values by the volume that moved them) and follow the trade's
+   * own row. A basket's or pair's value is output once all its legs have
+   * traded; a basket's value also moves the pairs it is a leg of.
+   */
+  void update_synthetics(const SymbolState &state, const ParsedRow &row,
+                         const RowTiming &timing) {
+    for (const BasketLeg &leg : state.baskets) {
+      Basket &basket = baskets[leg.basket];
+      if (basket.update(leg.constituent, row.price)) {
+        apply_synthetic(basket.name(), basket_symbols[leg.basket],
+                        basket.value(), 0.0, row, timing);
+      }
+    }
+    for (const PairLeg &leg : state.pairs) {
+      PairSeries &pair = pairs[leg.pair];
+      if (pair.update(leg.side, row.price)) {
+        apply_synthetic(pair.legs().name, pair_symbols[leg.pair],
+                        pair.value(), pair.zscore(), row, timing);
+      }
+    }
+  }
+
+  /**
+   * @brief Updates a synthetic symbol with a new value and outputs it
+   * @param name The synthetic symbol
+   * @param state The symbol's state, created on its first value
+   * @param price The new value
+   * @param zscore The value's z-score (pairs only)
+   * @param trigger The trade that moved the value
+   * @param timing The trade's latency timestamps
+   */
+  void apply_synthetic(const std::string &name, SymbolState *&state,
+                       double price, double zscore, const ParsedRow &trigger,
+                       const RowTiming &timing) {
+    if (state == nullptr) {
+      state = &get_or_create_symbol(name);
+    }
+    if (synthetic_used == synthetic_rows.size()) {
+      synthetic_rows.emplace_back();
+    }
+    ParsedRow &row = synthetic_rows[synthetic_used++];
+    row.timestamp = trigger.timestamp;
+    row.symbol = name;
+    row.price = price;
+    row.volume = trigger.volume;
+    row.is_valid = true;
+
+    observe_row(row, *state);
+    state->series.update(row.price, row.volume, row.timestamp);
+    if (outputs_rows()) {
+      pending_output.push_back(make_output_row(row, *state, timing));
+      pending_output.back().zscore = zscore;
+    }
+    update_synthetics(*state, row, timing);
+  }
+
+  /**
+   * @brief Starts the output: the sink, or what replaces per-row output
+   */
+  void begin_output() {
+    if (xsection) {
+      xsection->begin();
+    } else if (bars) {
+      bars->begin();
+    } else {
+      sink->begin(result_columns);
+    }
+  }
+
+  /**
+   * @brief Applies what the input's end releases: rows held for reordering,
+   * the cross-section's last bucket, the summary and the index's directory
+   */
+  void end_input() {
+    if (config.reorder_ticks) {
+      flush_reorder_buffer();
+    }
+    index_writer.finish();
+    if (xsection) {
+      xsection->finish();
+    }
+    if (summary) {
+      summary->report();
+    }
+  }
+
+  /**
+   * @brief Hands every queued output row to the sink as one columnar batch
+   * @param t_updated When the rows' updates finished (latency only)
+   * @param flush Whether the sink should flush its destination afterwards
+   *
+   * The sink's write() (formatting, for CSV) is charged to the format stage
+   * and its commit() to the write stage.
+   */
+  void write_output(uint64_t t_updated, bool flush) {
+    if (bars) {
+      bars->commit(flush);
+    }
+    output_columns.fill(pending_output, result_columns);
+    sink->write(output_columns.view(symbol_names));
+    profile_lap(ProfileStage::FORMAT);
+
+    [[maybe_unused]] const size_t bytes = sink->commit(flush);
+    ANALYZER_PROBE3(output_flush, bytes, pending_output.size(), flush);
+    profile_lap(ProfileStage::WRITE);
+
+    if (config.report_latency) {
+      record_latency(t_updated);
+    }
+    pending_output.clear();
+    released_rows.clear();
+    synthetic_used = 0;
+  }
+
+  /**
+   * @brief Records the latency of every row just written
+   * @param t_updated When the rows' updates finished
+   *
+   * The periodic report's deadline is checked once per batch, whether or not
+   * the batch emitted rows, so a feed whose rows are all filtered or held
+   * still reports (with rows=0). A feed that stops sending bytes altogether
+   * reports at its next batch.
+   */
+  void record_latency(uint64_t t_updated) {
+    uint64_t t_emitted = latency_now_ns();
+    auto &histograms = latency.local();
+    for (const OutputRow &out : pending_output) {
+      const RowTiming &t = out.timing;
+      histograms[static_cast<size_t>(LatencyStage::PARSE)].record(
+          t.parsed_ns - t.available_ns);
+      if (t.held) {
+        histograms[static_cast<size_t>(LatencyStage::HOLD)].record(
+            t.released_ns - t.parsed_ns);
+      }
+      histograms[static_cast<size_t>(LatencyStage::UPDATE)].record(
+          t_updated - t.released_ns);
+      histograms[static_cast<size_t>(LatencyStage::OUTPUT)].record(
+          t_emitted - t_updated);
+      histograms[static_cast<size_t>(LatencyStage::TOTAL)].record(
+          t_emitted - t.available_ns);
+    }
+
+    if (next_latency_report != 0 && t_emitted >= next_latency_report) {
+      diagnose([&](std::ostream &out) { latency.report_interval(out); });
+      next_latency_report = t_emitted + config.latency_interval_ns;
+    }
+  }
+
+  /**
+   * @brief Applies a cancel or amend row to its symbol's indicator state
+   * @param row The correction row
+   *
+   * Corrections update state silently; the corrected indicator values show
+   * up on the symbol's next output row. Without --corrections no journal is
+   * kept, so correction rows are counted and skipped.
+   */
+  void apply_correction(const ParsedRow &row) {
+    if (config.correction_checkpoint_interval == 0) {
+      corrections_ignored++;
+      return;
+    }
+
+    auto log = correction_logs.find(row.symbol);
+    if (log == correction_logs.end() ||
+        !log->second.apply(row, symbol_data.at(row.symbol).series)) {
+      corrections_unmatched++;
+    }
+  }
+
+  /**
+   * @brief Writes diagnostics to stderr (or set_diagnostics()), taking turns
+   * with the progress thread
+   * @param write Called as write(stream) while the lock is held
+   */
+  template <typename Write> void diagnose(Write &&write) const {
+    std::lock_guard<std::mutex> lock(diagnostics_mutex());
+    write(*diagnostics);
+  }
+
+  /**
+   * @brief Reports corrections that could not be applied
+   */
+  void report_corrections() const {
+    diagnose([&](std::ostream &out) {
+      if (corrections_ignored > 0) {
+        out << "Warning: " << corrections_ignored
+            << " correction rows ignored (enable with --corrections=N)\n";
+      }
+      if (corrections_unmatched > 0) {
+        out << "Warning: " << corrections_unmatched
+            << " corrections did not match a journaled trade\n";
+      }
+    });
+  }
+
+  /**
+   * @brief Releases every row still held for reordering at end of input
+   *
+   * Remaining rows are emitted in timestamp order, then the counts of late
+   * ticks and of rows without a timestamp are reported if any were seen.
+   */
+  void flush_reorder_buffer() {
+    reorder_buffer.drain([&](PendingRow &pending) { release_row(pending); });
+    profile_lap(ProfileStage::UPDATE);
+    write_output(config.report_latency ? latency_now_ns() : 0, true);
+
+    const std::string fate =
+        late_output.is_open()
+            ? "written to '" + config.late_output_filename + "'"
+            : std::string("dropped");
+    if (late_rows > 0) {
+      diagnose([&](std::ostream &out) {
+        out << "Warning: " << late_rows
+            << " ticks arrived later than --max-lateness and were " << fate
+            << '\n';
+      });
+    }
+    if (untimed_rows > 0) {
+      diagnose([&](std::ostream &out) {
+        out << "Warning: " << untimed_rows
+            << " rows had no valid timestamp to reorder them by and were "
+            << fate << '\n';
+      });
+    }
+  }
+
+  /**
+   * @brief Captures a row and its symbol's current indicator values
+   * @param row The row to output
+   * @param state The symbol's Series (current indicator values) and id
+   * @param timing The row's latency timestamps (--latency only)
+   * @return OutputRow with the requested indicator values filled in
+   */
+  OutputRow make_output_row(const ParsedRow &row, const SymbolState &state,
+                            const RowTiming &timing = {}) const {
+    const Series &series = state.series;
+    OutputRow out;
+    out.row = &row;
+    out.symbol_id = state.id;
+    out.timing = timing;
+    if (config.output_sma) {
+      out.sma = series.get_indicator(IndicatorType::SMA);
+    }
+    if (config.output_ema) {
+      out.ema = series.get_indicator(IndicatorType::EMA);
+    }
+    if (config.output_vol) {
+      out.volatility = series.get_indicator(IndicatorType::VOLATILITY);
+    }
+    if (config.output_vwap) {
+      out.vwap = series.get_indicator(IndicatorType::VWAP);
+    }
+    return out;
+  }
+};
+
+#endif
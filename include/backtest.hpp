@@ -0,0 +1,248 @@
+#ifndef BACKTEST_HPP
+#define BACKTEST_HPP
+
+#include "analyzer.hpp"
+#include "csv.hpp"
+#include "sweep.hpp"
+#include "workers.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct CrossoverRule
+ * @brief "Long while the fast average is above the slow one", as matrix
+ * columns of the shared IndicatorFamily
+ */
+struct CrossoverRule {
+  int32_t fast;       ///< Fast window or span
+  int32_t slow;       ///< Slow window or span
+  size_t fast_column; ///< Column of the fast average
+  size_t slow_column; ///< Column of the slow average
+};
+
+/**
+ * @struct BacktestBook
+ * @brief One symbol's running results for every rule, rule by rule
+ *
+ * Strategy returns are per-tick simple returns earned while long, minus
+ * costs; they are summed (not compounded), so pnl is in units of notional
+ * (0.01 = 1%).
+ */
+struct BacktestBook {
+  std::vector<uint8_t> position;  ///< 1 while long
+  std::vector<double> pnl;        ///< Sum of strategy returns
+  std::vector<double> sum_sq;     ///< Sum of squared strategy returns
+  std::vector<double> peak;       ///< Highest pnl so far
+  std::vector<double> drawdown;   ///< Largest fall from a peak so far
+  std::vector<uint64_t> trades;   ///< Position changes
+  uint64_t returns = 0;           ///< Ticks with a return (Sharpe's n)
+
+  explicit BacktestBook(size_t rules)
+      : position(rules), pnl(rules), sum_sq(rules), peak(rules),
+        drawdown(rules), trades(rules) {}
+
+  /**
+   * @brief Sharpe ratio of the per-tick strategy returns (not annualized)
+   */
+  double sharpe(size_t rule) const {
+    if (returns < 2) {
+      return 0.0;
+    }
+    const double n = static_cast<double>(returns);
+    const double mean = pnl[rule] / n;
+    const double variance = (sum_sq[rule] - pnl[rule] * mean) / (n - 1);
+    return variance > 0 ? mean / std::sqrt(variance) : 0.0;
+  }
+};
+
+/**
+ * @class BacktestRunner
+ * @brief Evaluates a grid of crossover rules on every symbol (--backtest)
+ *
+ * Every fast and slow parameter of the grid is one column of a single
+ * IndicatorFamily, so each average is computed once per row however many
+ * rules use it. Each batch, the WorkerPool first splits the columns and
+ * then the rules between threads; rules only read the shared matrix and
+ * write their own slots of the symbols' books.
+ *
+ * A rule's signal is taken after the row's update and earns from the next
+ * tick on, so there is no look-ahead. Until a symbol has `slow` updates the
+ * rule stays flat. Every change of position costs --cost basis points.
+ */
+class BacktestRunner {
+  CLIConfig config;
+  CLIConfig reader_config; ///< Defaults: the reader only parses
+  CSVAnalyzer reader;      ///< Reads and parses the batches
+  IndicatorFamily family;
+  std::vector<CrossoverRule> rules;
+  std::vector<BacktestBook> books; ///< By symbol id
+  WorkerPool workers;
+  InputBatch batch;
+  double cost;             ///< Cost per unit traded, as a fraction
+
+  /**
+   * @brief Returns the sorted union of the grid's fast and slow parameters
+   */
+  static std::vector<int32_t> grid_columns(const CLIConfig &config) {
+    std::vector<int32_t> columns = config.backtest_fast.values();
+    for (int32_t slow : config.backtest_slow.values()) {
+      columns.push_back(slow);
+    }
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()),
+                  columns.end());
+    return columns;
+  }
+
+  /**
+   * @brief Returns every fast < slow pair of the grid, fast-major
+   */
+  static std::vector<CrossoverRule> grid_rules(const CLIConfig &config,
+                                               const std::vector<int32_t> &
+                                                   columns) {
+    auto column_of = [&](int32_t parameter) {
+      return static_cast<size_t>(
+          std::lower_bound(columns.begin(), columns.end(), parameter) -
+          columns.begin());
+    };
+    std::vector<CrossoverRule> grid;
+    for (int32_t fast : config.backtest_fast.values()) {
+      for (int32_t slow : config.backtest_slow.values()) {
+        if (fast < slow) {
+          grid.push_back({fast, slow, column_of(fast), column_of(slow)});
+        }
+      }
+    }
+    return grid;
+  }
+
+  /**
+   * @brief Advances rules [begin, end) over the batch's rows
+   */
+  void rule_block(size_t begin, size_t end) {
+    const size_t width = family.parameters().size();
+    for (size_t r = 0; r < family.rows.size(); ++r) {
+      if (!family.row_updated[r]) {
+        continue; // Seeding rows change neither values nor returns
+      }
+      BacktestBook &book = books[family.row_symbols[r]->id];
+      const double *values = family.matrix.data() + r * width;
+      const double tick = family.row_returns[r];
+      const uint64_t count = family.row_count[r];
+      for (size_t k = begin; k < end; ++k) {
+        const CrossoverRule &rule = rules[k];
+        double gain = book.position[k] ? tick : 0.0;
+        const uint8_t want =
+            count >= static_cast<uint64_t>(rule.slow) &&
+            values[rule.fast_column] > values[rule.slow_column];
+        if (want != book.position[k]) {
+          gain -= cost;
+          book.trades[k]++;
+          book.position[k] = want;
+        }
+        book.pnl[k] += gain;
+        book.sum_sq[k] += gain * gain;
+        book.peak[k] = std::max(book.peak[k], book.pnl[k]);
+        book.drawdown[k] =
+            std::max(book.drawdown[k], book.peak[k] - book.pnl[k]);
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Prepares a backtest
+   * @param backtest_config Configuration with --backtest set
+   */
+  explicit BacktestRunner(const CLIConfig &backtest_config)
+      : config(backtest_config), reader(reader_config),
+        family(backtest_config.backtest_indicator,
+               grid_columns(backtest_config)),
+        rules(grid_rules(backtest_config, family.parameters())),
+        workers(worker_threads(backtest_config,
+                               std::max(family.parameters().size(),
+                                        rules.size()))),
+        cost(backtest_config.cost_bps / 10'000.0) {
+    batch.allocate();
+  }
+
+  /**
+   * @brief Backtests a stream
+   * @param input Stream positioned at the first data line
+   * @return true once the stream has been fully consumed
+   */
+  bool run(std::istream &input) {
+    const std::function<void(size_t, size_t)> columns =
+        [this](size_t begin, size_t end) { family.compute(begin, end); };
+    const std::function<void(size_t, size_t)> grid =
+        [this](size_t begin, size_t end) { rule_block(begin, end); };
+    bool more = true;
+    while (more) {
+      more = reader.read_batch(input, batch);
+      reader.parse_batch(batch);
+      family.collect(batch, config.filter_symbol);
+      while (books.size() < family.symbol_names().size()) {
+        books.emplace_back(rules.size());
+      }
+      for (size_t r = 0; r < family.rows.size(); ++r) {
+        books[family.row_symbols[r]->id].returns += family.row_updated[r];
+      }
+      workers.run(family.parameters().size(), columns);
+      workers.run(rules.size(), grid);
+      family.end_batch();
+    }
+    return true;
+  }
+
+  /**
+   * @brief Prints one CSV row per symbol and rule
+   */
+  void report(std::ostream &out) const {
+    out << "symbol,fast,slow,pnl,trades,sharpe,max_drawdown\n";
+    std::string line;
+    for (size_t id = 0; id < books.size(); ++id) {
+      const BacktestBook &book = books[id];
+      for (size_t k = 0; k < rules.size(); ++k) {
+        line = family.symbol_names()[id];
+        line += ',' + std::to_string(rules[k].fast);
+        line += ',' + std::to_string(rules[k].slow);
+        line += ',' + std::to_string(book.pnl[k]);
+        line += ',' + std::to_string(book.trades[k]);
+        line += ',' + std::to_string(book.sharpe(k));
+        line += ',' + std::to_string(book.drawdown[k]);
+        line += '\n';
+        out << line;
+      }
+    }
+  }
+};
+
+/**
+ * @brief Runs --backtest over config.input_filename and prints the results
+ * @return false (after printing an error) if the input cannot be opened
+ */
+inline bool run_backtest(const CLIConfig &config) {
+  BacktestRunner runner(config);
+  if (config.input_filename == "-") {
+    runner.run(std::cin);
+  } else {
+    std::ifstream input(config.input_filename);
+    if (!input.is_open()) {
+      std::cerr << "Error: Cannot open file '" << config.input_filename
+                << "'\n";
+      return false;
+    }
+    runner.run(input);
+  }
+  runner.report(std::cout);
+  return true;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef BARS_HPP
+#define BARS_HPP
+
+#include "indicators.hpp"
+#include "sink.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @enum BarKind
+ * @brief What closes a bar (--bars=KIND:THRESHOLD)
+ */
+enum class BarKind {
+  VOLUME, ///< Every THRESHOLD shares
+  DOLLAR, ///< Every THRESHOLD of notional (price * shares)
+  TICKS   ///< Every THRESHOLD trades
+};
+
+/**
+ * @struct Bar
+ * @brief One bar of a symbol's trades
+ */
+struct Bar {
+  double open = 0.0;    ///< First price
+  double high = 0.0;    ///< Highest price
+  double low = 0.0;     ///< Lowest price
+  double close = 0.0;   ///< Last price
+  int64_t volume = 0;   ///< Shares
+  double dollars = 0.0; ///< Notional
+  uint64_t ticks = 0;   ///< Trades (a trade split across bars counts in each)
+
+  /**
+   * @brief Adds (part of) a trade
+   */
+  void add(double price, int64_t shares) {
+    if (ticks++ == 0) {
+      open = high = low = price;
+    }
+    high = std::max(high, price);
+    low = std::min(low, price);
+    close = price;
+    volume += shares;
+    dollars += price * static_cast<double>(shares);
+  }
+};
+
+/**
+ * @class BarSampler
+ * @brief Volume, dollar and tick bars per symbol (--bars)
+ *
+ * Each symbol accumulates trades into its open bar, in a dense array
+ * indexed by symbol id. A trade that takes a volume or dollar bar past its
+ * threshold is split: just enough shares to reach the threshold close the
+ * bar (for dollar bars, the smallest whole number of shares that reaches
+ * it), and the rest of the trade opens the next bar, closing further bars
+ * while it still exceeds the threshold. A bar still open at the end of the
+ * input is not printed.
+ *
+ * Bar rows are
+ *   timestamp,symbol,open,high,low,close,volume,dollar_volume,ticks
+ *   [,sma,ema,volatility,vwap]
+ * where timestamp is that of the trade that closed the bar and the
+ * indicator columns come from the symbol's Series, which the caller
+ * updates with each bar's close and volume rather than with every trade.
+ */
+class BarSampler {
+  BarKind kind;           ///< What closes a bar
+  double threshold;       ///< Shares, notional or trades per bar
+  ResultColumns columns;  ///< Indicator columns printed
+  std::ostream &out;      ///< Destination
+  std::vector<Bar> open;  ///< Open bar, by symbol id
+  std::string buffer;     ///< Rows formatted since the last commit
+
+  /**
+   * @brief Appends a comma and a value to the buffer
+   */
+  void field(double value) {
+    buffer += ',';
+    buffer += std::to_string(value);
+  }
+
+public:
+  /**
+   * @brief Creates a sampler
+   * @param bar_kind What closes a bar
+   * @param bar_threshold Shares, notional or trades per bar (positive)
+   * @param indicator_columns Indicators added to bar rows
+   * @param destination Where the rows go
+   */
+  BarSampler(BarKind bar_kind, double bar_threshold,
+             const ResultColumns &indicator_columns, std::ostream &destination)
+      : kind(bar_kind), threshold(bar_threshold), columns(indicator_columns),
+        out(destination) {}
+
+  /**
+   * @brief Prints the header
+   */
+  void begin() {
+    std::string header = "timestamp,symbol,open,high,low,close,volume,"
+                         "dollar_volume,ticks";
+    header += columns.sma ? ",sma" : "";
+    header += columns.ema ? ",ema" : "";
+    header += columns.volatility ? ",volatility" : "";
+    header += columns.vwap ? ",vwap" : "";
+    out << header << '\n';
+  }
+
+  /**
+   * @brief Adds a trade to its symbol's open bar
+   * @param id The symbol's id
+   * @param price The trade's price
+   * @param volume The trade's volume
+   * @param on_close Called as on_close(bar) for every bar the trade closes,
+   * in order
+   */
+  template <typename OnClose>
+  void add(uint32_t id, double price, int64_t volume, OnClose &&on_close) {
+    if (id >= open.size()) {
+      open.resize(id + 1);
+    }
+    Bar &bar = open[id];
+    if (kind == BarKind::TICKS) {
+      bar.add(price, volume);
+      if (static_cast<double>(bar.ticks) >= threshold) {
+        on_close(bar);
+        bar = Bar();
+      }
+      return;
+    }
+    if (kind == BarKind::DOLLAR && !(price > 0)) {
+      bar.add(price, volume); // Adds no notional
+      return;
+    }
+    int64_t rest = volume;
+    for (;;) {
+      // Shares that would take the bar to its threshold
+      const double missing = kind == BarKind::VOLUME
+                                 ? threshold - static_cast<double>(bar.volume)
+                                 : (threshold - bar.dollars) / price;
+      if (static_cast<double>(rest) < std::floor(missing)) {
+        break;
+      }
+      int64_t shares =
+          std::max<int64_t>(static_cast<int64_t>(std::ceil(missing)), 0);
+      if (kind == BarKind::DOLLAR) {
+        // The division rounds: settle on the same sum Bar::add accumulates
+        auto reaches = [&](int64_t n) {
+          return bar.dollars + price * static_cast<double>(n) >= threshold;
+        };
+        while (shares > 0 && reaches(shares - 1)) {
+          shares--;
+        }
+        while (!reaches(shares)) {
+          shares++;
+        }
+      }
+      if (shares > rest) {
+        break;
+      }
+      bar.add(price, shares);
+      on_close(bar);
+      bar = Bar();
+      rest -= shares;
+      if (rest == 0) {
+        return;
+      }
+    }
+    bar.add(price, rest);
+  }
+
+  /**
+   * @brief Formats a closed bar with its symbol's indicators
+   * @param timestamp Timestamp of the trade that closed the bar
+   * @param symbol The symbol
+   * @param bar The bar
+   * @param series The symbol's indicators, already updated with the bar
+   */
+  void write(std::string_view timestamp, std::string_view symbol,
+             const Bar &bar, const Series &series) {
+    buffer += timestamp;
+    buffer += ',';
+    buffer += symbol;
+    field(bar.open);
+    field(bar.high);
+    field(bar.low);
+    field(bar.close);
+    buffer += ',' + std::to_string(bar.volume);
+    field(bar.dollars);
+    buffer += ',' + std::to_string(bar.ticks);
+    if (columns.sma) {
+      field(series.get_indicator(IndicatorType::SMA));
+    }
+    if (columns.ema) {
+      field(series.get_indicator(IndicatorType::EMA));
+    }
+    if (columns.volatility) {
+      field(series.get_indicator(IndicatorType::VOLATILITY));
+    }
+    if (columns.vwap) {
+      field(series.get_indicator(IndicatorType::VWAP));
+    }
+    buffer += '\n';
+  }
+
+  /**
+   * @brief Writes the rows formatted since the last commit
+   * @param flush Whether to flush the destination afterwards
+   */
+  void commit(bool flush) {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (flush) {
+      out.flush();
+    }
+    buffer.clear();
+  }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Writes a trivially copyable value in native byte order
+ * @param out Destination stream (opened in binary mode)
+ * @param value Value to write
+ *
+ * Binary files written by the analyzer (snapshot indexes, result files) are
+ * meant to be read back on the same platform, so no byte swapping is done.
+ */
+template <typename T> void write_binary(std::ostream &out, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * @brief Reads a trivially copyable value written by write_binary()
+ * @param in Source stream (opened in binary mode)
+ * @param value Receives the value
+ * @return true if the full value was read
+ */
+template <typename T> bool read_binary(std::istream &in, T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+/**
+ * @brief Writes a length-prefixed string
+ */
+inline void write_binary_string(std::ostream &out, const std::string &text) {
+  write_binary(out, static_cast<uint32_t>(text.size()));
+  out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+/**
+ * @brief Reads a string written by write_binary_string()
+ * @return true if the full string was read
+ */
+inline bool read_binary_string(std::istream &in, std::string &text) {
+  uint32_t length;
+  if (!read_binary(in, length)) {
+    return false;
+  }
+  text.resize(length);
+  return static_cast<bool>(in.read(text.data(), length));
+}
+
+#endif
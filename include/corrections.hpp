@@ -0,0 +1,205 @@
+#ifndef CORRECTIONS_HPP
+#define CORRECTIONS_HPP
+
+#include "csv.hpp"
+#include "indicators.hpp"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @struct JournalTick
+ * @brief A trade remembered so that it can later be cancelled or amended
+ */
+struct JournalTick {
+  std::string timestamp;  ///< Trade timestamp (correction lookup key)
+  double price;           ///< Current (possibly amended) price
+  long volume;            ///< Current (possibly amended) volume
+  bool cancelled = false; ///< Set once the trade has been retracted
+};
+
+/**
+ * @class CorrectionLog
+ * @brief Per-symbol trade journal with periodic Series checkpoints
+ *
+ * Applies cancel and amend messages for earlier trades without re-running the
+ * whole input:
+ * - Amends of a trade that is still inside the indicator windows patch the
+ *   invertible aggregates (SMA sum, volatility sums, VWAP sums) in O(1) and
+ *   rebuild only the EMA by replaying prices from the nearest checkpoint.
+ * - Cancels shift window membership, so the Series is restored from the
+ *   nearest checkpoint before the cancelled trade and the journal is replayed
+ *   without it.
+ *
+ * A checkpoint (a copy of the Series) is taken every `interval` trades. Only
+ * the last MAX_CHECKPOINTS checkpoints and the trades after the oldest one are
+ * kept, so corrections can reach back at least (MAX_CHECKPOINTS - 1) *
+ * interval trades; older trades are reported as unmatched. Checkpoints taken
+ * after a corrected trade are discarded, since they describe the history
+ * before the correction.
+ */
+class CorrectionLog {
+public:
+  static constexpr size_t MAX_CHECKPOINTS = 4; ///< Checkpoints retained
+
+private:
+  /**
+   * @struct Checkpoint
+   * @brief Series state after every trade before journal index `next`
+   */
+  struct Checkpoint {
+    uint64_t next; ///< Absolute index of the first trade not included
+    Series state;  ///< Series as it was at that point
+  };
+
+  std::deque<JournalTick> ticks;      ///< Trades since the oldest checkpoint
+  uint64_t first_index = 0;           ///< Absolute index of ticks.front()
+  std::deque<Checkpoint> checkpoints; ///< Oldest first, never empty
+  size_t interval;                    ///< Trades between checkpoints
+
+  /**
+   * @brief Finds the most recent live trade with the given timestamp
+   * @param ts Timestamp to look for
+   * @param age Receives the number of live trades after the match
+   * @return Journal position of the match, or ticks.size() if none
+   */
+  size_t find(const std::string &ts, size_t &age) const {
+    age = 0;
+    for (size_t pos = ticks.size(); pos-- > 0;) {
+      if (ticks[pos].cancelled)
+        continue;
+      if (ticks[pos].timestamp == ts)
+        return pos;
+      age++;
+    }
+    return ticks.size();
+  }
+
+  /**
+   * @brief Restores a checkpoint and replays every live trade after it
+   * @param series Series to rebuild in place
+   * @param from Checkpoint to restore
+   */
+  void replay(Series &series, const Checkpoint &from) const {
+    series = from.state;
+    for (size_t pos = from.next - first_index; pos < ticks.size(); ++pos) {
+      const JournalTick &tick = ticks[pos];
+      if (!tick.cancelled) {
+        series.update(tick.price, tick.volume, tick.timestamp);
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Starts a journal for a symbol that has not traded yet
+   * @param checkpoint_interval Trades between checkpoints (must be > 0)
+   * @param initial The symbol's freshly constructed Series
+   */
+  CorrectionLog(size_t checkpoint_interval, const Series &initial)
+      : interval(checkpoint_interval) {
+    checkpoints.push_back({0, initial});
+  }
+
+  /**
+   * @brief Journals a trade that has just been applied to the Series
+   * @param row The trade
+   * @param after The Series state after applying it
+   */
+  void record(const ParsedRow &row, const Series &after) {
+    ticks.push_back({row.timestamp, row.price, row.volume});
+
+    const uint64_t next = first_index + ticks.size();
+    if (next % interval != 0) {
+      return;
+    }
+    checkpoints.push_back({next, after});
+
+    // Forget the oldest checkpoint and the trades only it could replay
+    if (checkpoints.size() > MAX_CHECKPOINTS) {
+      checkpoints.pop_front();
+      while (first_index < checkpoints.front().next) {
+        ticks.pop_front();
+        first_index++;
+      }
+    }
+  }
+
+  /**
+   * @brief Applies a cancel or amend row to the journal and the Series
+   * @param row The correction (timestamp identifies the earlier trade)
+   * @param series The symbol's live Series, corrected in place
+   * @return false if no live trade with that timestamp is still journaled
+   */
+  bool apply(const ParsedRow &row, Series &series) {
+    size_t age;
+    size_t pos = find(row.timestamp, age);
+    if (pos == ticks.size()) {
+      return false;
+    }
+    JournalTick &target = ticks[pos];
+
+    // Checkpoints taken after the corrected trade no longer describe the
+    // corrected history; the one we restore from always precedes it
+    while (checkpoints.back().next > first_index + pos) {
+      checkpoints.pop_back();
+    }
+    const Checkpoint &base = checkpoints.back();
+    const size_t base_pos = base.next - first_index;
+
+    if (row.action == RowAction::CANCEL) {
+      target.cancelled = true;
+      replay(series, base);
+      return true;
+    }
+
+    // Amend: locate the neighbouring live trades whose returns involve it
+    double prev_price = base.state.get_last_price();
+    for (size_t i = pos; i-- > base_pos;) {
+      if (!ticks[i].cancelled) {
+        prev_price = ticks[i].price;
+        break;
+      }
+    }
+    double next_price = 0.0;
+    for (size_t i = pos + 1; i < ticks.size(); ++i) {
+      if (!ticks[i].cancelled) {
+        next_price = ticks[i].price;
+        break;
+      }
+    }
+
+    const double old_price = target.price;
+    const long old_volume = target.volume;
+    target.price = row.price;
+    target.volume = row.volume;
+
+    if (prev_price == 0) {
+      // The series' first trade never entered the indicators: replay fully
+      replay(series, base);
+      return true;
+    }
+
+    series.amend_invertible(age, prev_price, next_price, old_price,
+                            old_volume, row.price, row.volume,
+                            target.timestamp);
+
+    // Volume-only corrections leave every price-driven indicator intact
+    if (row.price == old_price) {
+      return true;
+    }
+
+    std::vector<double> prices;
+    prices.reserve(ticks.size() - base_pos);
+    for (size_t i = base_pos; i < ticks.size(); ++i) {
+      if (!ticks[i].cancelled) {
+        prices.push_back(ticks[i].price);
+      }
+    }
+    series.replay_ema(base.state, prices);
+    return true;
+  }
+};
+
+#endif
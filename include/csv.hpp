@@ -1,10 +1,50 @@
 #ifndef CSV_HPP
 #define CSV_HPP
 
+#include <cctype>
 #include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct ParameterRange
+ * @brief Windows or spans first, first + step, ..., up to last
+ */
+struct ParameterRange {
+  int first = 0; ///< First parameter
+  int last = 0;  ///< Last parameter (inclusive)
+  int step = 1;  ///< Distance between parameters
+
+  /**
+   * @brief Returns every parameter of the range, in order
+   */
+  std::vector<int32_t> values() const {
+    std::vector<int32_t> parameters;
+    for (int64_t p = first; p <= last; p += step) {
+      parameters.push_back(static_cast<int32_t>(p));
+    }
+    return parameters;
+  }
+};
+
+/**
+ * @struct PairSpec
+ * @brief Legs and kind of a --pair series
+ */
+struct PairSpec {
+  std::string first;  ///< First leg's symbol
+  std::string second; ///< Second leg's symbol
+  bool spread = false; ///< first - beta * second; otherwise first / second
+  double beta = 1.0;   ///< Hedge ratio of a spread
+  std::string name;    ///< Symbol of the series ("A/B", "A-B", "A-0.8*B")
+};
 
 /**
  * @struct CLIConfig
@@ -34,6 +74,8 @@ struct CLIConfig {
   bool output_vol = false; ///< Flag to enable volume output (set via --vol=N)
   bool output_vwap =
       false; ///< Flag to enable VWAP output (set via --vwap=daily)
+  std::string output_format =
+      "csv"; ///< Output sink: "csv", "binary" or "null" (set via --output=F)
 
   // ========== Filtering and Input Options ==========
 
@@ -42,6 +84,97 @@ struct CLIConfig {
   std::string input_filename = ""; ///< Path to input CSV file
   std::string vwap_reset_period =
       ""; ///< VWAP reset period (currently only "daily" is supported)
+
+  // ========== Diagnostics ==========
+
+  bool report_latency =
+      false; ///< Record per-row latency histograms (set via --latency=T)
+  int64_t latency_interval_ns =
+      0; ///< Interval between periodic latency reports; 0 reports only at exit
+  bool profile_stages =
+      false; ///< Print per-stage cycles and time per row at exit (--profile)
+  bool profile_hardware =
+      false; ///< Also read hardware counters per stage (--profile=hw)
+  int64_t progress_interval_ns =
+      0; ///< Interval between progress lines on stderr; 0 disables them
+         ///< (set via --progress[=T])
+  std::string trace_filename =
+      ""; ///< Where a Chrome trace of the pipeline stages is written
+          ///< (set via --trace=PATH); empty disables tracing
+
+  // ========== Out-of-Order Handling ==========
+
+  bool reorder_ticks = false; ///< Hold rows in a reorder buffer
+                              ///< (set via --max-lateness=T)
+  int64_t max_lateness_ns =
+      0; ///< How far behind the newest timestamp a tick may arrive
+  std::string late_output_filename =
+      ""; ///< Where late ticks are written; empty means they are dropped
+
+  // ========== Trade Corrections ==========
+
+  size_t correction_checkpoint_interval =
+      0; ///< Trades between per-symbol checkpoints; 0 disables corrections
+         ///< (set via --corrections=N)
+
+  // ========== Snapshot Index and As-Of Queries ==========
+
+  std::string build_index_filename =
+      ""; ///< Write per-symbol snapshots here while processing
+  uint64_t index_every_rows =
+      10000; ///< Rows per symbol between snapshots (0 = use index_every_ns)
+  int64_t index_every_ns = 0;       ///< Time between a symbol's snapshots
+  std::string index_filename = "";  ///< Index used to answer --as-of queries
+  std::string as_of_symbol = "";    ///< Symbol queried by --as-of=SYM@TS
+  std::string as_of_timestamp = ""; ///< Time queried by --as-of=SYM@TS
+
+  // ========== Fan-Out ==========
+
+  std::string config_file = ""; ///< Job list run over one input pass
+                                ///< (set via --config-file=PATH)
+
+  // ========== Parameter Sweep ==========
+
+  std::string sweep_indicator = ""; ///< Indicator swept ("sma" or "ema");
+                                    ///< empty disables the sweep
+  ParameterRange sweep_range; ///< Windows or spans swept
+
+  // ========== Backtest ==========
+
+  std::string backtest_indicator = ""; ///< Crossover indicator ("sma" or
+                                       ///< "ema"); empty disables backtests
+  ParameterRange backtest_fast; ///< Fast windows or spans of the grid
+  ParameterRange backtest_slow; ///< Slow windows or spans of the grid
+  double cost_bps = 0.0; ///< Transaction cost per unit traded, in basis
+                         ///< points of notional (set via --cost=BPS)
+
+  unsigned threads = 0; ///< Worker threads for --sweep and --backtest
+                        ///< (0 = one per core)
+
+  // ========== Cross-Section ==========
+
+  int64_t xsection_ns = 0; ///< Bucket length of the cross-section; 0 prints
+                           ///< rows instead (set via --xsection=T)
+  bool xsection_universe = false; ///< Print one summary per bucket instead
+                                  ///< of one row per symbol (":universe")
+
+  bool summary = false; ///< Print per-symbol aggregates at the end instead
+                        ///< of rows (set via --summary)
+
+  // ========== Bars ==========
+
+  std::string bar_kind = ""; ///< "volume", "dollar" or "ticks"; empty
+                             ///< outputs trades (set via --bars=KIND:N)
+  double bar_threshold = 0.0; ///< Shares, notional or trades per bar
+
+  // ========== Synthetic Symbols ==========
+
+  std::vector<std::string> baskets; ///< "name:weights.csv" of every basket
+                                    ///< (set via --basket, repeatable)
+  std::vector<PairSpec> pairs; ///< Ratio and spread series (set via --pair,
+                               ///< repeatable)
+  size_t pair_window = 100;    ///< Values in the pair z-score's window
+                               ///< (set via --pair-window=N)
 };
 
 /**
@@ -58,6 +191,20 @@ struct ParseStats {
   size_t parse_failures = 0; ///< Number of lines that failed to parse correctly
 };
 
+/**
+ * @enum RowAction
+ * @brief What a row asks the analyzer to do, from the optional 5th column
+ *
+ * Plain trades have no 5th column. Correction rows refer to an earlier trade
+ * of the same symbol by its timestamp (the most recent trade with that
+ * timestamp is the one corrected).
+ */
+enum class RowAction {
+  TRADE,  ///< A new trade (5th column absent or empty)
+  CANCEL, ///< "X": retract the earlier trade with this timestamp
+  AMEND   ///< "A": replace that trade's price and volume with this row's
+};
+
 /**
  * @struct ParsedRow
  * @brief Represents a single parsed row from the CSV input
@@ -72,6 +219,7 @@ struct ParsedRow {
   double price;          ///< Price value for this data point
   long volume;           ///< Trading volume for this data point
   bool is_valid;         ///< Indicates whether this row was successfully parsed
+  RowAction action = RowAction::TRADE; ///< Trade or correction of a trade
 
   /**
    * @brief Factory method to create an invalid ParsedRow
@@ -103,6 +251,39 @@ struct FieldRange {
   const char *end() const { return start + length; }
 };
 
+/**
+ * @brief Parses a price field
+ * @param field The field to parse (need not be NUL-terminated, but must be
+ * followed by a non-numeric character such as ',' or the string's NUL)
+ * @param price Receives the parsed value
+ * @return true if the whole field is a valid number
+ *
+ * Uses strtod, which is faster than std::stod as it works directly with char*
+ * without string allocation.
+ */
+inline bool parse_price(const FieldRange &field, double &price) {
+  char *end_ptr;
+  price = strtod(field.start, &end_ptr);
+
+  // Ensure we consumed characters and reached the end of the field
+  return end_ptr != field.start && end_ptr == field.end();
+}
+
+/**
+ * @brief Parses a volume field
+ * @param field The field to parse
+ * @param volume Receives the parsed value
+ * @return true if the field starts with a valid integer
+ *
+ * Uses std::from_chars: no locale, no allocation, no exceptions.
+ */
+inline bool parse_volume(const FieldRange &field, long &volume) {
+  auto result = std::from_chars(field.start, field.end(), volume);
+
+  // Check for parsing errors (std::errc{} represents success)
+  return result.ec == std::errc{};
+}
+
 /**
  * @brief Converts EMA span parameter to smoothing factor (alpha)
  * @param span The span parameter (number of periods)
@@ -117,7 +298,193 @@ struct FieldRange {
  * Example: span=50 → alpha=0.0392 (3.92% weight on new value, 96.08% on
  * previous EMA)
  */
-double span_to_alpha(int span) { return 2.0 / (span + 1.0); }
+inline double span_to_alpha(int span) { return 2.0 / (span + 1.0); }
+
+/**
+ * @brief Parses a parameter range "FIRST..LAST[:STEP]" or a single "N"
+ * @param text The range
+ * @param flag Flag name used in error messages
+ * @throws std::invalid_argument unless 0 < FIRST <= LAST and STEP > 0
+ */
+inline ParameterRange parse_parameter_range(const std::string &text,
+                                            const std::string &flag) {
+  ParameterRange range;
+  const auto dots = text.find("..");
+  const auto step = text.find(':');
+  size_t used = 0;
+  range.first = std::stoi(text, &used);
+  range.last = range.first;
+  if (dots != std::string::npos) {
+    if (used != dots) {
+      throw std::invalid_argument(flag + " expects FIRST..LAST[:STEP]");
+    }
+    range.last = std::stoi(text.substr(dots + 2), &used);
+    used += dots + 2;
+    if (step != std::string::npos) {
+      if (used != step || step < dots) {
+        throw std::invalid_argument(flag + " expects FIRST..LAST[:STEP]");
+      }
+      range.step = std::stoi(text.substr(step + 1), &used);
+      used += step + 1;
+    }
+  }
+  if (used != text.size()) {
+    throw std::invalid_argument(flag + " expects FIRST..LAST[:STEP]");
+  }
+  if (range.first <= 0 || range.last < range.first || range.step <= 0) {
+    throw std::invalid_argument(flag +
+                                " needs 0 < FIRST <= LAST and a positive STEP");
+  }
+  return range;
+}
+
+/**
+ * @brief Parses a pair "A:B:ratio" or "A:B:spread[:BETA]"
+ * @throws std::invalid_argument if the text has another form, the legs are
+ * the same symbol or BETA is not a finite number
+ */
+inline PairSpec parse_pair_spec(const std::string &text) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  for (size_t colon; (colon = text.find(':', start)) != std::string::npos;
+       start = colon + 1) {
+    parts.push_back(text.substr(start, colon - start));
+  }
+  parts.push_back(text.substr(start));
+
+  PairSpec pair;
+  const bool ratio = parts.size() == 3 && parts[2] == "ratio";
+  pair.spread = (parts.size() == 3 || parts.size() == 4) &&
+                parts[2] == "spread";
+  if ((!ratio && !pair.spread) || parts[0].empty() || parts[1].empty() ||
+      parts[0] == parts[1]) {
+    throw std::invalid_argument(
+        "--pair expects A:B:ratio or A:B:spread[:BETA] with A != B");
+  }
+  pair.first = parts[0];
+  pair.second = parts[1];
+  pair.name = pair.first + (ratio ? "/" : "-");
+  if (parts.size() == 4) {
+    const std::string &beta = parts[3];
+    const auto [end, ec] =
+        std::from_chars(beta.data(), beta.data() + beta.size(), pair.beta);
+    if (ec != std::errc() || end != beta.data() + beta.size() ||
+        !std::isfinite(pair.beta)) {
+      throw std::invalid_argument("--pair expects a number as BETA");
+    }
+    if (pair.beta != 1.0) {
+      pair.name += parts[3] + "*";
+    }
+  }
+  pair.name += pair.second;
+  return pair;
+}
+
+/**
+ * @brief Parses a duration such as "500ms", "5s" or "1m" into nanoseconds
+ * @param text Duration text: a non-negative integer followed by an optional
+ * unit (ns, us, ms, s, m, h); a bare number is taken as seconds
+ * @return Duration in nanoseconds
+ * @throws std::invalid_argument if the text is not a valid duration or does
+ * not fit in 64-bit nanoseconds
+ */
+inline int64_t parse_duration_ns(const std::string &text) {
+  int64_t amount = 0;
+  auto result =
+      std::from_chars(text.data(), text.data() + text.size(), amount);
+  if (result.ec != std::errc{} || amount < 0) {
+    throw std::invalid_argument("Invalid duration: " + text);
+  }
+
+  std::string unit(result.ptr, text.data() + text.size());
+  int64_t scale;
+  if (unit.empty() || unit == "s") {
+    scale = 1'000'000'000;
+  } else if (unit == "ms") {
+    scale = 1'000'000;
+  } else if (unit == "us") {
+    scale = 1'000;
+  } else if (unit == "ns") {
+    scale = 1;
+  } else if (unit == "m") {
+    scale = 60'000'000'000;
+  } else if (unit == "h") {
+    scale = 3'600'000'000'000;
+  } else {
+    throw std::invalid_argument("Invalid duration unit: " + text);
+  }
+  if (amount > std::numeric_limits<int64_t>::max() / scale) {
+    throw std::invalid_argument("Duration out of range: " + text);
+  }
+  return amount * scale;
+}
+
+/**
+ * @brief Parses a timestamp into nanoseconds since the Unix epoch (UTC)
+ * @param text Timestamp in "YYYY-MM-DD HH:MM:SS" form, optionally with a 'T'
+ * separator and up to nine fractional-second digits; a bare "YYYY-MM-DD" is
+ * taken as midnight
+ * @param out Receives the parsed time on success
+ * @return true if the text is a valid timestamp, false otherwise
+ *
+ * Hand-rolled digit parsing keeps this allocation-free and cheap enough to
+ * call once per row. Calendar conversion uses the days-from-civil algorithm,
+ * so no time zone database or locale is involved.
+ */
+inline bool parse_timestamp_ns(std::string_view text, int64_t &out) {
+  auto digits = [&](size_t pos, size_t count, int &value) {
+    if (pos + count > text.size())
+      return false;
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+      char c = text[i];
+      if (c < '0' || c > '9')
+        return false;
+      value = value * 10 + (c - '0');
+    }
+    return true;
+  };
+
+  int year, month, day, hour = 0, minute = 0, second = 0;
+  if (!digits(0, 4, year) || text.size() < 10 || text[4] != '-' ||
+      !digits(5, 2, month) || text[7] != '-' || !digits(8, 2, day) ||
+      month < 1 || month > 12 || day < 1 || day > 31) {
+    return false;
+  }
+
+  int64_t fraction_ns = 0;
+  if (text.size() > 10) {
+    if ((text[10] != ' ' && text[10] != 'T') || text.size() < 19 ||
+        !digits(11, 2, hour) || text[13] != ':' || !digits(14, 2, minute) ||
+        text[16] != ':' || !digits(17, 2, second) || hour > 23 ||
+        minute > 59 || second > 60) {
+      return false;
+    }
+    if (text.size() > 19) {
+      size_t n = text.size() - 20;
+      int value;
+      if (text[19] != '.' || n == 0 || n > 9 || !digits(20, n, value)) {
+        return false;
+      }
+      fraction_ns = value;
+      for (size_t i = n; i < 9; ++i) {
+        fraction_ns *= 10;
+      }
+    }
+  }
+
+  // Days since 1970-01-01 (proleptic Gregorian calendar)
+  int64_t y = year - (month <= 2);
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int64_t days = era * 146097 + doe - 719468;
+
+  out = ((days * 24 + hour) * 60 + minute) * 60 + second;
+  out = out * 1'000'000'000 + fraction_ns;
+  return true;
+}
 
 /**
  * @brief Parses command-line arguments into a CLIConfig structure
@@ -134,12 +501,62 @@ double span_to_alpha(int span) { return 2.0 / (span + 1.0); }
  *   --vwap=daily   : Enable VWAP calculation with daily reset (only "daily"
  * supported)
  *   --symbol=SYM   : Filter output to only show data for symbol SYM
+ *   --output=F     : Write rows as "csv" (default), "binary" columns, or
+ * discard them ("null")
+ *   --latency=T    : Report per-row latency percentiles every T (e.g. "5s")
+ * and at exit; T=0 reports only at exit
+ *   --profile[=hw] : Print cycles and nanoseconds per row spent in each
+ * pipeline stage at exit; "hw" adds hardware counters (instructions, IPC,
+ * cache, branch and TLB misses) per row
+ *   --progress[=T] : Print bytes done, throughput, ETA, symbols and the
+ * parse-failure rate to stderr every T (default 10s)
+ *   --trace=PATH   : Write a Chrome trace-event timeline of every batch's
+ * pipeline stages to PATH (open in Perfetto or chrome://tracing)
+ *   --max-lateness=T : Reorder ticks by timestamp, tolerating ticks up to T
+ * (e.g. "500ms") behind the newest one seen on any symbol
+ *   --late-output=PATH : Write ticks later than --max-lateness, and rows
+ * without a valid timestamp, to PATH instead of dropping them
+ *   --corrections=N : Apply cancel/amend rows (5th column "X"/"A"), keeping a
+ * per-symbol checkpoint every N trades
+ *   --build-index=PATH : Write per-symbol Series snapshots to PATH
+ *   --index-every=N|T  : Snapshot every N rows of a symbol, or every duration
+ * T (e.g. "5m") of its timestamps (default: 10000 rows), and at least every
+ * 4 MiB of input
+ *   --as-of=SYM@TS : Print SYM's indicators as of timestamp TS using the
+ * snapshot index given by --index=PATH
+ *   --config-file=PATH : Run every job of the job file PATH over one pass of
+ * the input
+ *   --sweep=IND:A..B[:S] : Compute SMA windows or EMA spans A, A+S, ..., B
+ * in one pass and write them as a binary matrix
+ *   --backtest=IND:FAST/SLOW : Backtest "long while the fast SMA/EMA is
+ * above the slow one" per symbol for every FAST < SLOW (each a value or a
+ * range) and print PnL, trades, Sharpe and drawdown at exit
+ *   --cost=BPS     : Backtest transaction cost in basis points per unit traded
+ *   --threads=N    : Worker threads for --sweep and --backtest (default: one
+ * per core)
+ *   --xsection=T[:universe] : Instead of rows, print every symbol's bucket
+ * return with its rank and z-score across symbols at the end of every
+ * bucket of length T, or one universe summary per bucket
+ *   --bars=KIND:N  : Instead of rows, print a bar per symbol every N shares
+ * (volume), N of notional (dollar) or N trades (ticks), splitting trades
+ * across bars, with the indicators updated on bar closes
+ *   --summary      : Instead of rows, print one row of aggregates (count,
+ * first/last timestamp, min/max/mean price, volume, final indicators, max
+ * drawdown) per symbol at the end of the input
+ *   --basket=NAME:PATH : Output the weighted basket of the "symbol,weight"
+ * lines of PATH as symbol NAME, updated on every constituent trade once all
+ * have traded (repeatable)
+ *   --pair=A:B:ratio | A:B:spread[:BETA] : Output the series A / B or
+ * A - BETA * B, updated whenever either leg trades, with the rolling z-score
+ * of its last --pair-window=N values (default 100) as an extra column
+ * (repeatable)
  *   filename       : Any non-flag argument is treated as the input filename
+ *                    ("-" reads from standard input)
  *
  * Example usage:
  *   ./program --sma=20 --ema=50 --symbol=AAPL data.csv
  */
-CLIConfig parse_cli_args(int argc, char *argv[]) {
+inline CLIConfig parse_cli_args(int argc, char *argv[]) {
   CLIConfig config;
 
   // Iterate through all command-line arguments (skip program name at argv[0])
@@ -168,6 +585,162 @@ CLIConfig parse_cli_args(int argc, char *argv[]) {
           config.output_vol = true; // Enable volume output
         } else if (key == "symbol") {
           config.filter_symbol = value;
+        } else if (key == "output") {
+          if (value != "csv" && value != "binary" && value != "null") {
+            throw std::invalid_argument(
+                "--output supports 'csv', 'binary' or 'null'");
+          }
+          config.output_format = value;
+        } else if (key == "latency") {
+          config.latency_interval_ns = parse_duration_ns(value);
+          config.report_latency = true;
+        } else if (key == "profile") {
+          if (value != "hw" && value != "time") {
+            throw std::invalid_argument("--profile supports 'time' or 'hw'");
+          }
+          config.profile_stages = true;
+          config.profile_hardware = value == "hw";
+        } else if (key == "progress") {
+          config.progress_interval_ns = parse_duration_ns(value);
+          if (config.progress_interval_ns <= 0) {
+            throw std::invalid_argument("--progress interval must be positive");
+          }
+        } else if (key == "trace") {
+          config.trace_filename = value;
+        } else if (key == "max-lateness") {
+          config.max_lateness_ns = parse_duration_ns(value);
+          config.reorder_ticks = true;
+        } else if (key == "late-output") {
+          config.late_output_filename = value;
+        } else if (key == "corrections") {
+          int interval = std::stoi(value);
+          if (interval <= 0) {
+            throw std::invalid_argument("--corrections must be positive");
+          }
+          config.correction_checkpoint_interval = interval;
+        } else if (key == "build-index") {
+          config.build_index_filename = value;
+        } else if (key == "index-every") {
+          // A trailing unit letter means a duration, otherwise a row count
+          if (!value.empty() && std::isalpha(
+                                    static_cast<unsigned char>(value.back()))) {
+            config.index_every_ns = parse_duration_ns(value);
+            config.index_every_rows = 0;
+            if (config.index_every_ns <= 0) {
+              throw std::invalid_argument("--index-every must be positive");
+            }
+          } else {
+            int rows = std::stoi(value);
+            if (rows <= 0) {
+              throw std::invalid_argument("--index-every must be positive");
+            }
+            config.index_every_rows = rows;
+          }
+        } else if (key == "index") {
+          config.index_filename = value;
+        } else if (key == "as-of") {
+          auto at_pos = value.find('@');
+          int64_t ignored;
+          if (at_pos == std::string::npos || at_pos == 0 ||
+              !parse_timestamp_ns(value.substr(at_pos + 1), ignored)) {
+            throw std::invalid_argument("--as-of expects SYMBOL@TIMESTAMP");
+          }
+          config.as_of_symbol = value.substr(0, at_pos);
+          config.as_of_timestamp = value.substr(at_pos + 1);
+        } else if (key == "sweep") {
+          // IND:FIRST..LAST[:STEP]
+          const auto colon = value.find(':');
+          config.sweep_indicator = value.substr(0, colon);
+          if (colon == std::string::npos ||
+              (config.sweep_indicator != "sma" &&
+               config.sweep_indicator != "ema")) {
+            throw std::invalid_argument(
+                "--sweep expects sma:FIRST..LAST[:STEP] or ema:...");
+          }
+          config.sweep_range =
+              parse_parameter_range(value.substr(colon + 1), "--sweep");
+        } else if (key == "backtest") {
+          // IND:FAST/SLOW, each a single value or a range
+          const auto colon = value.find(':');
+          const auto slash = value.find('/');
+          config.backtest_indicator = value.substr(0, colon);
+          if (colon == std::string::npos || slash == std::string::npos ||
+              slash < colon ||
+              (config.backtest_indicator != "sma" &&
+               config.backtest_indicator != "ema")) {
+            throw std::invalid_argument(
+                "--backtest expects sma:FAST/SLOW or ema:FAST/SLOW");
+          }
+          config.backtest_fast = parse_parameter_range(
+              value.substr(colon + 1, slash - colon - 1), "--backtest");
+          config.backtest_slow =
+              parse_parameter_range(value.substr(slash + 1), "--backtest");
+          if (config.backtest_fast.first >= config.backtest_slow.last) {
+            throw std::invalid_argument(
+                "--backtest needs a fast parameter below a slow one");
+          }
+        } else if (key == "cost") {
+          config.cost_bps = std::stod(value);
+          if (!(config.cost_bps >= 0)) {
+            throw std::invalid_argument("--cost must not be negative");
+          }
+        } else if (key == "xsection") {
+          const auto colon = value.find(':');
+          config.xsection_ns = parse_duration_ns(value.substr(0, colon));
+          const std::string mode =
+              colon == std::string::npos ? "symbols" : value.substr(colon + 1);
+          if (config.xsection_ns <= 0 ||
+              (mode != "symbols" && mode != "universe")) {
+            throw std::invalid_argument(
+                "--xsection expects a positive duration, optionally followed "
+                "by ':symbols' or ':universe'");
+          }
+          config.xsection_universe = mode == "universe";
+        } else if (key == "basket") {
+          const auto colon = value.find(':');
+          if (colon == 0 || colon == std::string::npos ||
+              colon + 1 == value.size()) {
+            throw std::invalid_argument("--basket expects NAME:WEIGHTS.csv");
+          }
+          config.baskets.push_back(value);
+        } else if (key == "pair") {
+          config.pairs.push_back(parse_pair_spec(value));
+        } else if (key == "pair-window") {
+          int window = std::stoi(value);
+          if (window < 2) {
+            throw std::invalid_argument("--pair-window must be at least 2");
+          }
+          config.pair_window = window;
+        } else if (key == "bars") {
+          const auto colon = value.find(':');
+          config.bar_kind = value.substr(0, colon);
+          const std::string threshold =
+              colon == std::string::npos ? "" : value.substr(colon + 1);
+          const auto [end, ec] = std::from_chars(
+              threshold.data(), threshold.data() + threshold.size(),
+              config.bar_threshold);
+          if (ec != std::errc() ||
+              end != threshold.data() + threshold.size() ||
+              !(config.bar_threshold > 0) ||
+              !std::isfinite(config.bar_threshold) ||
+              (config.bar_kind != "volume" && config.bar_kind != "dollar" &&
+               config.bar_kind != "ticks")) {
+            throw std::invalid_argument(
+                "--bars expects volume:N, dollar:X or ticks:N");
+          }
+          if (config.bar_kind != "dollar" &&
+              config.bar_threshold != std::floor(config.bar_threshold)) {
+            throw std::invalid_argument("--bars=" + config.bar_kind +
+                                        " needs a whole number");
+          }
+        } else if (key == "threads") {
+          int threads = std::stoi(value);
+          if (threads <= 0) {
+            throw std::invalid_argument("--threads must be positive");
+          }
+          config.threads = threads;
+        } else if (key == "config-file") {
+          config.config_file = value;
         } else if (key == "vwap") {
           // Only "daily" is currently supported for VWAP
           if (value == "daily") {
@@ -179,6 +752,13 @@ CLIConfig parse_cli_args(int argc, char *argv[]) {
           // Unrecognized flag key
           throw std::invalid_argument("Unknown key: " + key);
         }
+      } else if (arg == "--profile") {
+        // Switches take no value
+        config.profile_stages = true;
+      } else if (arg == "--progress") {
+        config.progress_interval_ns = 10'000'000'000;
+      } else if (arg == "--summary") {
+        config.summary = true;
       } else {
         // Flag doesn't contain '=' separator
         throw std::invalid_argument("Invalid flag format: " + arg +
@@ -190,6 +770,67 @@ CLIConfig parse_cli_args(int argc, char *argv[]) {
     }
   }
 
+  if (!config.late_output_filename.empty() && !config.reorder_ticks) {
+    throw std::invalid_argument("--late-output requires --max-lateness");
+  }
+  if (!config.as_of_symbol.empty() && config.index_filename.empty()) {
+    throw std::invalid_argument("--as-of requires --index=PATH");
+  }
+  // Snapshots are replayed against raw file offsets, which only describe the
+  // state when rows are applied in file order without corrections
+  if ((!config.build_index_filename.empty() || !config.as_of_symbol.empty()) &&
+      (config.reorder_ticks || config.correction_checkpoint_interval != 0)) {
+    throw std::invalid_argument("Snapshot indexes cannot be combined with "
+                                "--max-lateness or --corrections");
+  }
+
+  if ((!config.sweep_indicator.empty() ||
+       !config.backtest_indicator.empty()) &&
+      (config.reorder_ticks || config.correction_checkpoint_interval != 0 ||
+       !config.build_index_filename.empty() || !config.as_of_symbol.empty())) {
+    throw std::invalid_argument("--sweep and --backtest cannot be combined "
+                                "with --max-lateness, --corrections or "
+                                "indexes");
+  }
+  if (!config.sweep_indicator.empty() && !config.backtest_indicator.empty()) {
+    throw std::invalid_argument("--sweep and --backtest are separate runs");
+  }
+  // Baskets and pairs follow the trades as they are applied; the other
+  // modes bypass or rewrite that stream, and a cross-section would count
+  // the synthetic values among the symbols they are made of
+  if ((!config.baskets.empty() || !config.pairs.empty()) &&
+      (!config.filter_symbol.empty() ||
+       config.correction_checkpoint_interval != 0 ||
+       !config.build_index_filename.empty() || !config.as_of_symbol.empty() ||
+       !config.sweep_indicator.empty() || !config.backtest_indicator.empty() ||
+       config.xsection_ns > 0)) {
+    throw std::invalid_argument("--basket and --pair cannot be combined with "
+                                "--symbol, --corrections, indexes, --sweep, "
+                                "--backtest or --xsection");
+  }
+  if ((config.xsection_ns > 0 || config.summary) &&
+      (!config.sweep_indicator.empty() || !config.backtest_indicator.empty() ||
+       !config.as_of_symbol.empty() || config.output_format != "csv")) {
+    throw std::invalid_argument("--xsection and --summary print their own "
+                                "CSV and cannot be combined with --sweep, "
+                                "--backtest, --as-of or --output");
+  }
+  if (config.xsection_ns > 0 && config.summary) {
+    throw std::invalid_argument("--xsection and --summary are separate runs");
+  }
+  // Bars replace the trades that every other row-level mode works on
+  if (!config.bar_kind.empty() &&
+      (config.xsection_ns > 0 || config.summary || !config.baskets.empty() ||
+       !config.pairs.empty() || config.correction_checkpoint_interval != 0 ||
+       !config.build_index_filename.empty() || !config.as_of_symbol.empty() ||
+       !config.sweep_indicator.empty() || !config.backtest_indicator.empty() ||
+       config.output_format != "csv")) {
+    throw std::invalid_argument(
+        "--bars prints its own CSV and cannot be combined with --xsection, "
+        "--summary, --basket, --pair, --corrections, indexes, --sweep, "
+        "--backtest or --output");
+  }
+
   return config;
 }
 
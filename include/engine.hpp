@@ -0,0 +1,122 @@
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include "csv.hpp"
+#include "sink.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+/**
+ * @struct EngineRow
+ * @brief One output row delivered to an Engine's row callback
+ *
+ * The string views point into the engine's buffers and are only valid for
+ * the duration of the callback; copy them to keep them.
+ */
+struct EngineRow {
+  std::string_view timestamp; ///< Timestamp as it appeared in the input
+  std::string_view symbol;    ///< Symbol of the trade
+  double price;               ///< Trade price
+  long volume;                ///< Trade volume
+  double sma;        ///< SMA after this trade (0 unless config.output_sma)
+  double ema;        ///< EMA after this trade (0 unless config.output_ema)
+  double volatility; ///< Volatility after this trade (0 unless output_vol)
+  double vwap;       ///< VWAP after this trade (0 unless output_vwap)
+  double zscore;     ///< Pair z-score (0 unless the row is a --pair's)
+};
+
+/**
+ * @class Engine
+ * @brief Push-based, embeddable form of the analyzer (libpriceanalytics)
+ *
+ * Programs that already hold market data in memory push CSV bytes in
+ * chunks of any size and receive every output row through a callback,
+ * instead of running the analyzer as a separate process and re-parsing its
+ * CSV output:
+ *
+ *   CLIConfig config;
+ *   config.output_sma = true;
+ *   Engine engine(config);
+ *   engine.on_row([](const EngineRow &row) { ... });
+ *   engine.push(bytes);   // as often as data arrives
+ *   engine.finish();      // at end of input
+ *
+ * Instead of a per-row callback, set_sink() attaches a ResultSink that
+ * receives whole batches as typed columns, e.g. to append them to an
+ * in-memory table with no per-row call at all.
+ *
+ * The configuration has the same meaning as on the command line (windows,
+ * symbol filter, --max-lateness, --corrections, --build-index); options
+ * that only concern the command-line tool, such as --profile, --progress
+ * and --trace, are ignored, and so is --output: rows only go to the
+ * callback or sink. --xsection, --summary and --bars, which print their
+ * own CSV instead of rows, are rejected, and so is --latency, whose reports
+ * an engine has nowhere to print. So are --sweep, --backtest,
+ * --config-file and --as-of, which are whole runs of their own rather than
+ * a row stream.
+ *
+ * An Engine is not thread-safe; use one per thread or feed.
+ */
+class Engine {
+public:
+  using RowCallback = std::function<void(const EngineRow &)>;
+
+  /**
+   * @brief Creates an engine with its own per-symbol state
+   * @param config Indicator parameters, outputs and options
+   * @throws std::runtime_error if a file the configuration writes
+   * (--late-output, --build-index) cannot be created
+   * @throws std::invalid_argument if the configuration asks for --xsection,
+   * --summary, --bars, --latency, --sweep, --backtest, --config-file or
+   * --as-of
+   */
+  explicit Engine(const CLIConfig &config);
+  ~Engine();
+
+  Engine(Engine &&) noexcept;
+  Engine &operator=(Engine &&) noexcept;
+
+  /**
+   * @brief Sets the function called for every output row, in output order
+   */
+  void on_row(RowCallback callback);
+
+  /**
+   * @brief Sends output batches to a sink instead of the row callback
+   * @param sink Receives every batch; must outlive the engine. Its begin()
+   * is called here with the configured indicator columns.
+   */
+  void set_sink(ResultSink &sink);
+
+  /**
+   * @brief Processes a chunk of CSV input
+   * @param bytes Any number of bytes; lines may be split across calls
+   *
+   * Rows of every complete line are delivered before push() returns.
+   */
+  void push(std::string_view bytes);
+
+  /**
+   * @brief Ends the input: processes an unterminated last line and releases
+   * rows still held for reordering (--max-lateness)
+   */
+  void finish();
+
+  /**
+   * @brief Non-empty lines seen so far
+   */
+  uint64_t lines() const;
+
+  /**
+   * @brief Lines that could not be parsed so far
+   */
+  uint64_t parse_failures() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+#endif
@@ -0,0 +1,430 @@
+#ifndef FANOUT_HPP
+#define FANOUT_HPP
+
+#include "analyzer.hpp"
+#include "csv.hpp"
+#include "sink.hpp"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct JobSpec
+ * @brief One job of a --config-file: its analysis flags and destination
+ */
+struct JobSpec {
+  CLIConfig config;   ///< The job's flags, as if given on the command line
+  std::string output; ///< File the job's rows are written to
+};
+
+/**
+ * @brief Reads the value of a `key = value` line of a job file
+ * @param text Everything after the '=', comments included
+ * @param flag Receives the value as a command-line flag value
+ * @param is_true Set if the value is the boolean true
+ * @return false if the value is false (the flag is left out)
+ * @throws std::invalid_argument if the value is not a string, integer or
+ * boolean
+ */
+inline bool parse_job_value(std::string_view text, std::string &flag,
+                            bool &is_true) {
+  auto trim = [](std::string_view s) {
+    const size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+      return std::string_view();
+    }
+    return s.substr(start, s.find_last_not_of(" \t\r") - start + 1);
+  };
+  text = trim(text);
+  flag.clear();
+  is_true = false;
+
+  size_t end;
+  if (!text.empty() && text.front() == '"') {
+    // Basic string: \" and \\ are the only escapes needed in flag values
+    for (end = 1; end < text.size() && text[end] != '"'; ++end) {
+      if (text[end] == '\\' && end + 1 < text.size()) {
+        ++end;
+      }
+      flag += text[end];
+    }
+    if (end == text.size()) {
+      throw std::invalid_argument("unterminated string");
+    }
+    ++end;
+  } else {
+    end = text.find('#');
+    flag = trim(text.substr(0, end));
+    end = end == std::string_view::npos ? text.size() : end;
+    if (flag == "true" || flag == "false") {
+      is_true = flag == "true";
+      return is_true;
+    }
+    const size_t digits = flag.find_first_not_of("+-") == 1 ? 1 : 0;
+    if (flag.size() == digits ||
+        flag.find_first_not_of("0123456789_", digits) != std::string::npos) {
+      throw std::invalid_argument("expected a string, integer or boolean");
+    }
+    std::erase(flag, '_');
+  }
+
+  std::string_view rest = trim(text.substr(end));
+  if (!rest.empty() && rest.front() != '#') {
+    throw std::invalid_argument("unexpected text after the value");
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the jobs of a --config-file
+ * @param input The job file, a subset of TOML (see below)
+ * @param name Name shown in error messages
+ * @return The jobs, in file order
+ * @throws std::invalid_argument (prefixed with name:line) on a syntax error,
+ * an invalid flag or a job without an output
+ *
+ * Each `[[job]]` table starts a job. Its `key = value` lines are the job's
+ * command-line flags without the dashes (`sma = 20` is --sma=20, underscores
+ * may stand for dashes), except `output`, the file the job writes, and
+ * `format`, its --output format. `true` gives a bare switch and `false`
+ * leaves the key out. Keys before the first `[[job]]` apply to every job.
+ * Flags that report on or replace the whole run (--latency, --profile,
+ * --progress, --trace, --index, --as-of, --sweep, --backtest) are not
+ * allowed in a job.
+ *
+ *   sma = 20
+ *
+ *   [[job]]
+ *   output = "aapl.csv"
+ *   symbol = "AAPL"
+ *   ema = 50
+ *
+ *   [[job]]
+ *   output = "all.bin"
+ *   format = "binary"
+ *   vwap = "daily"
+ */
+inline std::vector<JobSpec> parse_job_file(std::istream &input,
+                                           const std::string &name) {
+  struct Job {
+    std::vector<std::string> flags;
+    std::string output;
+    size_t line;
+  };
+  std::vector<std::string> common;
+  std::vector<Job> jobs;
+  std::set<std::string> outputs;
+
+  std::string line;
+  for (size_t number = 1; std::getline(input, line); ++number) {
+    auto fail = [&](const std::string &message) {
+      return std::invalid_argument(name + ":" + std::to_string(number) +
+                                   ": " + message);
+    };
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') {
+      continue;
+    }
+    std::string_view text = std::string_view(line).substr(start);
+    if (text.starts_with("[")) {
+      const size_t close = text.find("]]");
+      std::string_view rest =
+          close == std::string_view::npos ? "" : text.substr(close + 2);
+      rest = rest.substr(std::min(rest.find_first_not_of(" \t\r"),
+                                  rest.size()));
+      if (!text.starts_with("[[job]]") || (!rest.empty() && rest[0] != '#')) {
+        throw fail("only [[job]] tables are supported");
+      }
+      jobs.push_back({{}, "", number});
+      continue;
+    }
+
+    const size_t eq = text.find('=');
+    std::string key(text.substr(0, eq));
+    key.erase(key.find_last_not_of(" \t") + 1);
+    if (eq == std::string_view::npos || key.empty() ||
+        key.find_first_not_of("abcdefghijklmnopqrstuvwxyz0123456789_-") !=
+            std::string::npos) {
+      throw fail("expected key = value");
+    }
+    std::replace(key.begin(), key.end(), '_', '-');
+    if (key == "latency" || key == "profile" || key == "progress" ||
+        key == "trace" || key == "index" || key == "as-of" ||
+        key == "config-file" || key == "sweep" || key == "backtest" ||
+        key == "cost" || key == "threads") {
+      throw fail("'" + key + "' is not supported in a job");
+    }
+
+    std::string value;
+    bool is_true;
+    try {
+      if (!parse_job_value(text.substr(eq + 1), value, is_true)) {
+        continue;
+      }
+    } catch (const std::invalid_argument &e) {
+      throw fail(e.what());
+    }
+
+    if (key == "output") {
+      if (jobs.empty() || value.empty() || is_true) {
+        throw fail("output must be a file name inside a [[job]]");
+      }
+      if (!outputs.insert(value).second) {
+        throw fail("'" + value + "' is the output of another job");
+      }
+      jobs.back().output = value;
+      continue;
+    }
+    (jobs.empty() ? common : jobs.back().flags)
+        .push_back("--" + (key == "format" ? "output" : key) +
+                   (is_true ? "" : "=" + value));
+  }
+
+  if (jobs.empty()) {
+    throw std::invalid_argument(name + ": no [[job]] tables");
+  }
+  std::vector<JobSpec> specs;
+  for (Job &job : jobs) {
+    auto fail = [&](const std::string &message) {
+      return std::invalid_argument(name + ":" + std::to_string(job.line) +
+                                   ": " + message);
+    };
+    if (job.output.empty()) {
+      throw fail("job has no output");
+    }
+    std::vector<std::string> words{"analyzer"};
+    words.insert(words.end(), common.begin(), common.end());
+    words.insert(words.end(), job.flags.begin(), job.flags.end());
+    std::vector<char *> argv;
+    for (std::string &word : words) {
+      argv.push_back(word.data());
+    }
+    try {
+      specs.push_back({parse_cli_args(static_cast<int>(argv.size()),
+                                      argv.data()),
+                       job.output});
+    } catch (const std::exception &e) {
+      throw fail(e.what());
+    }
+  }
+  return specs;
+}
+
+/**
+ * @class JobRunner
+ * @brief Runs several jobs over one pass of the input (--config-file)
+ *
+ * The calling thread reads and parses the input once, into a small ring of
+ * batches. Every job is a CSVAnalyzer writing to its own output file,
+ * running on its own thread, that consumes each parsed batch in turn
+ * (filter, indicator updates, output) without modifying it. A ring slot is
+ * refilled only once every job has consumed it, so the slowest job sets the
+ * pace and memory stays bounded.
+ */
+class JobRunner {
+  static constexpr size_t RING_SLOTS = 4; ///< Batches in flight
+
+  /**
+   * @struct Job
+   * @brief A job's analyzer, destination and progress
+   */
+  struct Job {
+    JobSpec spec;
+    std::ofstream file;
+    std::unique_ptr<CSVAnalyzer> analyzer; ///< Writes to file
+    std::ostringstream warnings; ///< The analyzer's warnings, until joined
+    uint64_t consumed = 0;    ///< Batches consumed (guarded by mutex)
+    std::exception_ptr error; ///< Why the job stopped, if it failed
+  };
+
+  CLIConfig reader_config; ///< Defaults: no diagnostics for the reader
+  CSVAnalyzer reader;      ///< Reads and parses batches for every job
+  std::vector<std::unique_ptr<Job>> jobs;
+  std::array<InputBatch, RING_SLOTS> ring;
+
+  std::mutex mutex;
+  std::condition_variable batch_ready; ///< published or finished changed
+  std::condition_variable slot_free;   ///< A job's consumed count changed
+  uint64_t published = 0;              ///< Batches parsed so far
+  bool finished = false;               ///< The input is exhausted
+
+  /**
+   * @brief Returns true once every job has consumed batch `sequence`
+   */
+  bool consumed_by_all(uint64_t sequence) const {
+    for (const auto &job : jobs) {
+      if (job->consumed <= sequence) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief A job's thread: consumes every published batch in order
+   */
+  void consume(Job &job) {
+    try {
+      for (uint64_t next = 0;; ++next) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          batch_ready.wait(lock,
+                           [&] { return published > next || finished; });
+          if (published <= next) {
+            break;
+          }
+        }
+        job.analyzer->consume_batch(ring[next % RING_SLOTS], 0);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          job.consumed = next + 1;
+        }
+        slot_free.notify_one();
+      }
+      job.analyzer->finish_shared();
+      job.file.close();
+      if (!job.file) {
+        throw std::runtime_error("Cannot write '" + job.spec.output + "'");
+      }
+    } catch (...) {
+      // Stop holding back the reader; the error is reported after the run
+      std::lock_guard<std::mutex> lock(mutex);
+      job.error = std::current_exception();
+      job.consumed = std::numeric_limits<uint64_t>::max();
+      slot_free.notify_one();
+    }
+  }
+
+public:
+  /**
+   * @brief Creates the jobs' analyzers
+   * @param specs The jobs, e.g. from parse_job_file()
+   */
+  explicit JobRunner(std::vector<JobSpec> specs) : reader(reader_config) {
+    for (JobSpec &spec : specs) {
+      auto job = std::make_unique<Job>();
+      job->spec = std::move(spec);
+      job->analyzer =
+          std::make_unique<CSVAnalyzer>(job->spec.config, job->file);
+      job->analyzer->set_diagnostics(job->warnings);
+      jobs.push_back(std::move(job));
+    }
+    for (InputBatch &slot : ring) {
+      slot.allocate();
+    }
+  }
+
+  /**
+   * @brief Runs every job over a stream
+   * @param input Stream positioned at the first data line
+   * @return false (after printing an error) if an output cannot be created
+   * or a job failed; the other jobs still run to the end of the input
+   */
+  bool run(std::istream &input) {
+    for (const auto &job : jobs) {
+      job->file.open(job->spec.output, std::ios::binary);
+      if (!job->file.is_open()) {
+        std::cerr << "Error: Cannot open file '" << job->spec.output << "'\n";
+        return false;
+      }
+      if (!job->analyzer->begin_shared()) {
+        return false;
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for (const auto &job : jobs) {
+      threads.emplace_back([this, &job] { consume(*job); });
+    }
+
+    bool more = true;
+    for (uint64_t sequence = 0; more; ++sequence) {
+      if (sequence >= RING_SLOTS) {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_free.wait(lock, [&] {
+          return consumed_by_all(sequence - RING_SLOTS);
+        });
+      }
+      InputBatch &slot = ring[sequence % RING_SLOTS];
+      more = reader.read_batch(input, slot);
+      reader.parse_batch(slot);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        published = sequence + 1;
+      }
+      batch_ready.notify_all();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+    }
+    batch_ready.notify_all();
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    // Job threads only collected their warnings; print them in job order
+    for (const auto &job : jobs) {
+      std::istringstream lines(job->warnings.str());
+      for (std::string line; std::getline(lines, line);) {
+        std::cerr << "Job writing '" << job->spec.output << "': " << line
+                  << '\n';
+      }
+    }
+
+    bool ok = true;
+    for (const auto &job : jobs) {
+      if (!job->error) {
+        continue;
+      }
+      try {
+        std::rethrow_exception(job->error);
+      } catch (const std::exception &e) {
+        std::cerr << "Error: Job writing '" << job->spec.output
+                  << "' failed: " << e.what() << '\n';
+      }
+      ok = false;
+    }
+    return ok;
+  }
+};
+
+/**
+ * @brief Runs the jobs of config.config_file over config.input_filename
+ * @return false (after printing an error) if a file cannot be opened or a
+ * job failed
+ * @throws std::invalid_argument if the job file is invalid
+ */
+inline bool run_job_file(const CLIConfig &config) {
+  std::ifstream job_file(config.config_file);
+  if (!job_file.is_open()) {
+    std::cerr << "Error: Cannot open file '" << config.config_file << "'\n";
+    return false;
+  }
+  JobRunner runner(parse_job_file(job_file, config.config_file));
+
+  if (config.input_filename == "-") {
+    return runner.run(std::cin);
+  }
+  std::ifstream input(config.input_filename);
+  if (!input.is_open()) {
+    std::cerr << "Error: Cannot open file '" << config.input_filename << "'\n";
+    return false;
+  }
+  return runner.run(input);
+}
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef INDICATORS_HPP
 #define INDICATORS_HPP
 
+#include "binary_io.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <deque>
-#include <numeric>
+#include <span>
 #include <stdexcept>
 #include <string>
 
@@ -20,6 +24,101 @@ enum class IndicatorType {
   VWAP        ///< Volume-Weighted Average Price
 };
 
+/**
+ * @struct OutputSpans
+ * @brief Caller-provided arrays that batch updates write indicator values to
+ *
+ * Element i receives the indicator's value after row i of the batch, exactly
+ * as get_indicator() would return it after the corresponding update(). An
+ * empty span means the indicator is not wanted; the indicator still updates
+ * its state, but no values are written.
+ */
+struct OutputSpans {
+  std::span<double> sma;        ///< SMA after each row
+  std::span<double> ema;        ///< EMA after each row
+  std::span<double> volatility; ///< Volatility after each row
+  std::span<double> vwap;       ///< VWAP after each row
+
+  /**
+   * @brief Returns the same rows of every non-empty span
+   */
+  OutputSpans subspan(size_t offset, size_t count) const {
+    auto part = [&](std::span<double> values) {
+      return values.empty() ? values : values.subspan(offset, count);
+    };
+    return {part(sma), part(ema), part(volatility), part(vwap)};
+  }
+};
+
+/**
+ * @brief Writes a rolling window (size followed by values) in binary form
+ */
+inline void write_window(std::ostream &out, const std::deque<double> &window) {
+  write_binary(out, static_cast<uint64_t>(window.size()));
+  for (double value : window) {
+    write_binary(out, value);
+  }
+}
+
+/**
+ * @brief Reads a rolling window written by write_window()
+ * @return true if the whole window was read
+ */
+inline bool read_window(std::istream &in, std::deque<double> &window) {
+  uint64_t size;
+  if (!read_binary(in, size)) {
+    return false;
+  }
+  window.clear();
+  for (uint64_t i = 0; i < size; ++i) {
+    double value;
+    if (!read_binary(in, value)) {
+      return false;
+    }
+    window.push_back(value);
+  }
+  return true;
+}
+
+/**
+ * @struct RunningSum
+ * @brief Sliding-window sum that does not drift as values enter and leave
+ *
+ * A plain running sum keeps the rounding error of every large value that
+ * ever passed through it, so e.g. after a price jump leaves the window the
+ * sum of a flat stretch is no longer exact. Each addition here also
+ * accumulates its exact rounding error (Knuth's branch-free TwoSum), which
+ * keeps the result as accurate as summing the window from scratch at the
+ * cost of a few extra additions.
+ */
+struct RunningSum {
+  double sum = 0.0;          ///< Rounded running sum
+  double compensation = 0.0; ///< Accumulated rounding error of sum
+
+  /**
+   * @brief Adds a value (pass a negated value to remove it)
+   */
+  void add(double value) {
+    double total = sum + value;
+    double value_part = total - sum;
+    compensation += (sum - (total - value_part)) + (value - value_part);
+    sum = total;
+  }
+
+  /**
+   * @brief Returns the compensated sum
+   */
+  double value() const { return sum + compensation; }
+
+  /**
+   * @brief Resets to a known sum (e.g. one restored from a snapshot)
+   */
+  void assign(double value) {
+    sum = value;
+    compensation = 0.0;
+  }
+};
+
 /**
  * @class SMAIndicator
  * @brief Simple Moving Average calculator using a sliding window
@@ -33,7 +132,8 @@ enum class IndicatorType {
  */
 class SMAIndicator {
   std::deque<double> prices; ///< Rolling window of recent prices
-  int window_size;           ///< Maximum number of prices to maintain
+  RunningSum sum;            ///< Running sum of the prices in the window
+  size_t window_size;        ///< Maximum number of prices to maintain
 
 public:
   /**
@@ -47,17 +147,85 @@ public:
    * @param price The latest price value
    *
    * If the window is full (size == window_size), the oldest price
-   * is automatically removed before adding the new one.
+   * is automatically removed before adding the new one. The running sum is
+   * adjusted by the entering and leaving prices, so updates are O(1).
    */
   void update(double price) {
     prices.push_back(price);
+    sum.add(price);
 
     // Remove oldest price if window is full
     if (prices.size() > window_size) {
+      sum.add(-prices.front());
       prices.pop_front();
     }
   }
 
+  /**
+   * @brief Adds a batch of prices, writing the SMA after each one
+   * @param batch Prices in arrival order
+   * @param out Receives batch.size() values, or is empty to skip them
+   *
+   * Equivalent to calling update() and get_value() per price, with the
+   * running sum kept in registers across the batch.
+   */
+  void update_batch(std::span<const double> batch, std::span<double> out) {
+    RunningSum total = sum;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      prices.push_back(batch[i]);
+      total.add(batch[i]);
+      if (prices.size() > window_size) {
+        total.add(-prices.front());
+        prices.pop_front();
+      }
+      if (!out.empty()) {
+        out[i] = average(total, prices.size());
+      }
+    }
+    sum = total;
+  }
+
+  /**
+   * @brief Replaces a price that is still inside the window
+   * @param age Number of updates since the price was added (0 = newest)
+   * @param new_price Corrected price
+   * @return false if the price has already left the window (nothing changed)
+   *
+   * Used for trade corrections: the running sum is invertible, so an amended
+   * price is patched in O(1) without replaying history.
+   */
+  bool replace(size_t age, double new_price) {
+    if (age >= prices.size()) {
+      return false;
+    }
+    double &slot = prices[prices.size() - 1 - age];
+    sum.add(new_price);
+    sum.add(-slot);
+    slot = new_price;
+    return true;
+  }
+
+  /**
+   * @brief Serializes the window and running sum (for snapshots)
+   */
+  void save(std::ostream &out) const {
+    write_window(out, prices);
+    write_binary(out, sum.value());
+  }
+
+  /**
+   * @brief Restores state written by save()
+   * @return true on success
+   */
+  bool load(std::istream &in) {
+    double total;
+    if (!read_window(in, prices) || !read_binary(in, total)) {
+      return false;
+    }
+    sum.assign(total);
+    return true;
+  }
+
   /**
    * @brief Calculates the current Simple Moving Average
    * @return The average of all prices in the current window, or 0.0 if empty
@@ -65,12 +233,14 @@ public:
    * During the warm-up period (before window is full), calculates the average
    * of all available prices rather than waiting for the full window.
    */
-  double get_value() const {
-    if (prices.empty())
+  double get_value() const { return average(sum, prices.size()); }
+
+private:
+  static double average(const RunningSum &total, size_t count) {
+    if (count == 0)
       return 0.0;
 
-    return std::accumulate(prices.begin(), prices.end(), 0.0) /
-           static_cast<double>(prices.size());
+    return total.value() / static_cast<double>(count);
   }
 };
 
@@ -118,6 +288,51 @@ public:
     }
   }
 
+  /**
+   * @brief Adds a batch of prices, writing the EMA after each one
+   * @param prices Prices in arrival order
+   * @param out Receives prices.size() values, or is empty to skip them
+   */
+  void update_batch(std::span<const double> prices, std::span<double> out) {
+    size_t i = 0;
+    if (first_price && !prices.empty()) {
+      update(prices[0]);
+      if (!out.empty()) {
+        out[0] = current_ema;
+      }
+      i = 1;
+    }
+    double value = current_ema;
+    for (; i < prices.size(); ++i) {
+      value = alpha * prices[i] + (1 - alpha) * value;
+      if (!out.empty()) {
+        out[i] = value;
+      }
+    }
+    current_ema = value;
+  }
+
+  /**
+   * @brief Serializes the current EMA (for snapshots)
+   */
+  void save(std::ostream &out) const {
+    write_binary(out, current_ema);
+    write_binary(out, static_cast<uint8_t>(first_price));
+  }
+
+  /**
+   * @brief Restores state written by save()
+   * @return true on success
+   */
+  bool load(std::istream &in) {
+    uint8_t first;
+    if (!read_binary(in, current_ema) || !read_binary(in, first)) {
+      return false;
+    }
+    first_price = first != 0;
+    return true;
+  }
+
   /**
    * @brief Returns the current EMA value
    * @return The most recent exponential moving average
@@ -137,6 +352,9 @@ public:
  */
 class VolatilityIndicator {
   std::deque<double> returns; ///< Rolling window of percentage returns
+  std::deque<double> squares; ///< Squares of the returns, as added to sum_sq
+  RunningSum sum;             ///< Running sum of returns in the window
+  RunningSum sum_sq;          ///< Running sum of squared returns
   size_t window_size;         ///< Maximum number of returns to maintain
 
 public:
@@ -152,13 +370,99 @@ public:
    *
    * Returns should be calculated as: (current_price / previous_price) - 1.0
    * If the window is full, the oldest return is automatically removed.
+   * Running sums of returns and squared returns are maintained alongside the
+   * window so the variance never needs a second pass. Squares are kept so a
+   * leaving return removes exactly the value it added: recomputing it could
+   * round differently where the compiler fuses the multiply into the add.
    */
   void update(double return_val) {
     returns.push_back(return_val);
+    squares.push_back(return_val * return_val);
+    sum.add(return_val);
+    sum_sq.add(squares.back());
 
     if (returns.size() > window_size) {
+      sum.add(-returns.front());
+      sum_sq.add(-squares.front());
       returns.pop_front();
+      squares.pop_front();
+    }
+  }
+
+  /**
+   * @brief Adds a batch of returns, writing the volatility after each one
+   * @param batch Returns in arrival order
+   * @param out Receives batch.size() values, or is empty to skip them
+   */
+  void update_batch(std::span<const double> batch, std::span<double> out) {
+    RunningSum total = sum;
+    RunningSum total_sq = sum_sq;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      returns.push_back(batch[i]);
+      squares.push_back(batch[i] * batch[i]);
+      total.add(batch[i]);
+      total_sq.add(squares.back());
+      if (returns.size() > window_size) {
+        total.add(-returns.front());
+        total_sq.add(-squares.front());
+        returns.pop_front();
+        squares.pop_front();
+      }
+      if (!out.empty()) {
+        out[i] = deviation(total, total_sq, returns.size());
+      }
+    }
+    sum = total;
+    sum_sq = total_sq;
+  }
+
+  /**
+   * @brief Replaces a return that is still inside the window
+   * @param age Number of updates since the return was added (0 = newest)
+   * @param new_return Corrected return
+   * @return false if the return has already left the window (nothing changed)
+   */
+  bool replace(size_t age, double new_return) {
+    if (age >= returns.size()) {
+      return false;
+    }
+    double &slot = returns[returns.size() - 1 - age];
+    double &square = squares[squares.size() - 1 - age];
+    sum.add(new_return);
+    sum.add(-slot);
+    sum_sq.add(-square);
+    slot = new_return;
+    square = new_return * new_return;
+    sum_sq.add(square);
+    return true;
+  }
+
+  /**
+   * @brief Serializes the window and running sums (for snapshots)
+   */
+  void save(std::ostream &out) const {
+    write_window(out, returns);
+    write_binary(out, sum.value());
+    write_binary(out, sum_sq.value());
+  }
+
+  /**
+   * @brief Restores state written by save()
+   * @return true on success
+   */
+  bool load(std::istream &in) {
+    double total, total_sq;
+    if (!read_window(in, returns) || !read_binary(in, total) ||
+        !read_binary(in, total_sq)) {
+      return false;
+    }
+    squares.clear();
+    for (double r : returns) {
+      squares.push_back(r * r);
     }
+    sum.assign(total);
+    sum_sq.assign(total_sq);
+    return true;
   }
 
   /**
@@ -170,31 +474,90 @@ public:
    * Uses sample standard deviation (Bessel's correction with n-1 denominator)
    * rather than population standard deviation.
    */
-  double get_value() const {
-    if (returns.size() < 2) {
+  double get_value() const { return deviation(sum, sum_sq, returns.size()); }
+
+private:
+  static double deviation(const RunningSum &sum, const RunningSum &sum_sq,
+                          size_t count) {
+    if (count < 2) {
       return 0.0;
     }
 
-    size_t n = returns.size();
+    double n = static_cast<double>(count);
 
-    // Calculate mean of returns
-    double mean = std::accumulate(returns.begin(), returns.end(), 0.0) / n;
+    // Sum of squared differences from the mean: Σr² - (Σr)² / n
+    double total = sum.value();
+    double mean = total / n;
+    double sum_squared_diffs = sum_sq.value() - total * mean;
 
-    // Calculate sum of squared differences from mean
-    double sum_squared_diffs = 0.0;
-    for (const double &ret : returns) {
-      double diff = ret - mean;
-      sum_squared_diffs += diff * diff;
-    }
-
-    // Sample variance (using n-1 for Bessel's correction)
-    double variance = sum_squared_diffs / (n - 1);
+    // Sample variance (using n-1 for Bessel's correction); rounding in the
+    // running sums can push a near-zero variance slightly negative
+    double variance = std::max(sum_squared_diffs, 0.0) / (n - 1);
 
     // Return standard deviation (square root of variance)
     return std::sqrt(variance);
   }
 };
 
+/**
+ * @brief Returns the UTC day number (days since 1970-01-01) of a timestamp
+ * @param ts_ns Nanoseconds since the Unix epoch
+ */
+inline int64_t day_of_timestamp_ns(int64_t ts_ns) {
+  constexpr int64_t NS_PER_DAY = 86'400'000'000'000;
+  int64_t day = ts_ns / NS_PER_DAY;
+  return ts_ns % NS_PER_DAY < 0 ? day - 1 : day;
+}
+
+/**
+ * @brief Formats a day number as "YYYY-MM-DD"
+ * @param day Days since 1970-01-01 (proleptic Gregorian calendar)
+ *
+ * Inverse of the days-from-civil conversion in parse_timestamp_ns(), so the
+ * result equals the date prefix of the text a timestamp was parsed from.
+ */
+inline std::string format_day(int64_t day) {
+  int64_t z = day + 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  int64_t month = mp < 10 ? mp + 3 : mp - 9;
+  int64_t year = yoe + era * 400 + (month <= 2);
+  char text[32];
+  std::snprintf(text, sizeof(text), "%04lld-%02d-%02d",
+                static_cast<long long>(year), static_cast<int>(month),
+                static_cast<int>(doy - (153 * mp + 2) / 5 + 1));
+  return text;
+}
+
+/**
+ * @brief Formats nanoseconds since the epoch as "YYYY-MM-DD HH:MM:SS"
+ *
+ * Fractions of a second, if any, are appended as nine digits, so whole
+ * seconds print exactly like the input format parse_timestamp_ns() reads.
+ */
+inline std::string format_timestamp_ns(int64_t ts_ns) {
+  constexpr int64_t NS_PER_DAY = 86'400'000'000'000;
+  const int64_t day = day_of_timestamp_ns(ts_ns);
+  const int64_t ns_of_day = ts_ns - day * NS_PER_DAY;
+  const int64_t seconds = ns_of_day / 1'000'000'000;
+  const int64_t fraction = ns_of_day % 1'000'000'000;
+  char text[32];
+  std::snprintf(text, sizeof(text), " %02d:%02d:%02d",
+                static_cast<int>(seconds / 3600),
+                static_cast<int>(seconds / 60 % 60),
+                static_cast<int>(seconds % 60));
+  std::string result = format_day(day) + text;
+  if (fraction != 0) {
+    std::snprintf(text, sizeof(text), ".%09lld",
+                  static_cast<long long>(fraction));
+    result += text;
+  }
+  return result;
+}
+
 /**
  * @class VWAPIndicator
  * @brief Volume-Weighted Average Price calculator with daily reset
@@ -245,6 +608,83 @@ public:
     volume_sum += volume;
   }
 
+  /**
+   * @brief Adds a batch of trades, writing the VWAP after each one
+   * @param prices Trade prices
+   * @param volumes Trade volumes
+   * @param ts Trade times in nanoseconds since the Unix epoch (UTC)
+   * @param out Receives prices.size() values, or is empty to skip them
+   *
+   * The session resets when the UTC date changes. The date is only formatted
+   * when the day number changes, and is compared with the session date kept
+   * by update(), so both forms of update can be mixed on one indicator.
+   */
+  void update_batch(std::span<const double> prices,
+                    std::span<const int64_t> volumes,
+                    std::span<const int64_t> ts, std::span<double> out) {
+    double pv_sum = price_volume_sum;
+    long v_sum = volume_sum;
+    int64_t day = 0;
+    for (size_t i = 0; i < prices.size(); ++i) {
+      int64_t trade_day = day_of_timestamp_ns(ts[i]);
+      if (i == 0 || trade_day != day) {
+        day = trade_day;
+        std::string new_date = format_day(day);
+        if (current_date != new_date) {
+          pv_sum = 0.0;
+          v_sum = 0;
+          current_date = std::move(new_date);
+        }
+      }
+      pv_sum += prices[i] * volumes[i];
+      v_sum += volumes[i];
+      if (!out.empty()) {
+        out[i] = v_sum == 0 ? 0.0 : pv_sum / v_sum;
+      }
+    }
+    price_volume_sum = pv_sum;
+    volume_sum = v_sum;
+  }
+
+  /**
+   * @brief Replaces a previously added trade in the running totals
+   * @param old_price Original price of the trade
+   * @param old_volume Original volume of the trade
+   * @param new_price Corrected price
+   * @param new_volume Corrected volume
+   * @param timestamp Timestamp of the trade being amended
+   *
+   * Trades from an earlier day no longer contribute to the current VWAP, so
+   * amending them is a no-op. Otherwise the old contribution is subtracted
+   * and the new one added, which costs O(1).
+   */
+  void amend(double old_price, long old_volume, double new_price,
+             long new_volume, const std::string &timestamp) {
+    if (timestamp.compare(0, 10, current_date) != 0) {
+      return;
+    }
+    price_volume_sum += new_price * new_volume - old_price * old_volume;
+    volume_sum += new_volume - old_volume;
+  }
+
+  /**
+   * @brief Serializes the day's running totals (for snapshots)
+   */
+  void save(std::ostream &out) const {
+    write_binary(out, price_volume_sum);
+    write_binary(out, volume_sum);
+    write_binary_string(out, current_date);
+  }
+
+  /**
+   * @brief Restores state written by save()
+   * @return true on success
+   */
+  bool load(std::istream &in) {
+    return read_binary(in, price_volume_sum) && read_binary(in, volume_sum) &&
+           read_binary_string(in, current_date);
+  }
+
   /**
    * @brief Calculates the current VWAP value
    * @return Volume-weighted average price for the current day, or 0.0 if no
@@ -332,6 +772,163 @@ public:
     last_price = price;
   }
 
+  /**
+   * @brief Updates all indicators with a batch of data points
+   * @param prices Prices in arrival order
+   * @param volumes Volumes, one per price
+   * @param ts Timestamps in nanoseconds since the Unix epoch (UTC), as
+   * produced by parse_timestamp_ns(), one per price
+   * @param out Arrays of at least prices.size() values for the wanted
+   * indicators; empty spans are skipped
+   * @throws std::invalid_argument if the input or output sizes disagree
+   *
+   * Produces the same state and values as calling update() and
+   * get_indicator() row by row, including the first price of a series only
+   * seeding last_price. Each indicator runs its own loop over the batch with
+   * its state in locals, and returns are computed in a separate pass with no
+   * loop-carried dependency, so the compiler can vectorize it.
+   */
+  void update_batch(std::span<const double> prices,
+                    std::span<const int64_t> volumes,
+                    std::span<const int64_t> ts, OutputSpans out) {
+    const size_t n = prices.size();
+    auto too_small = [n](std::span<double> values) {
+      return !values.empty() && values.size() < n;
+    };
+    if (volumes.size() != n || ts.size() != n) {
+      throw std::invalid_argument("Batch inputs differ in length");
+    }
+    if (too_small(out.sma) || too_small(out.ema) ||
+        too_small(out.volatility) || too_small(out.vwap)) {
+      throw std::invalid_argument("Batch output span is too small");
+    }
+
+    constexpr size_t BLOCK = 256;
+    double returns[BLOCK];
+    size_t i = 0;
+    while (i < n) {
+      if (last_price == 0) {
+        // Seeds the series exactly like update(); indicators are unchanged
+        last_price = prices[i];
+        store_values(out, i);
+        ++i;
+        continue;
+      }
+
+      // Every row up to and including a zero price updates the indicators;
+      // the row after a zero price seeds the series again
+      size_t end = i;
+      while (end < n && end - i < BLOCK && prices[end] != 0) {
+        ++end;
+      }
+      if (end < n && end - i < BLOCK) {
+        ++end;
+      }
+
+      const size_t count = end - i;
+      const std::span<const double> block = prices.subspan(i, count);
+      returns[0] = (block[0] / last_price) - 1.0;
+      for (size_t k = 1; k < count; ++k) {
+        returns[k] = (block[k] / block[k - 1]) - 1.0;
+      }
+
+      const OutputSpans part = out.subspan(i, count);
+      sma.update_batch(block, part.sma);
+      ema.update_batch(block, part.ema);
+      volatility.update_batch(std::span<const double>(returns, count),
+                              part.volatility);
+      vwap.update_batch(block, volumes.subspan(i, count), ts.subspan(i, count),
+                        part.vwap);
+
+      last_price = block[count - 1];
+      i = end;
+    }
+  }
+
+  /**
+   * @brief Patches the invertible indicators for an amended earlier trade
+   * @param age Number of indicator updates since the amended trade (0 = the
+   * latest trade)
+   * @param prev_price Price of the trade before the amended one
+   * @param next_price Price of the trade after it (ignored when age == 0)
+   * @param old_price Original price of the amended trade
+   * @param old_volume Original volume of the amended trade
+   * @param new_price Corrected price
+   * @param new_volume Corrected volume
+   * @param ts Timestamp of the amended trade
+   *
+   * SMA, volatility and VWAP are sums and are patched in O(1): the SMA window
+   * slot, the two returns that involve the amended price, and the day's VWAP
+   * totals. Values that have already left a window need no change. EMA is not
+   * invertible and must be rebuilt separately with replay_ema().
+   *
+   * Must not be used for the very first trade of a series, which never
+   * entered the indicators.
+   */
+  void amend_invertible(size_t age, double prev_price, double next_price,
+                        double old_price, long old_volume, double new_price,
+                        long new_volume, const std::string &ts) {
+    sma.replace(age, new_price);
+
+    volatility.replace(age, (new_price / prev_price) - 1.0);
+    if (age > 0) {
+      volatility.replace(age - 1, (next_price / new_price) - 1.0);
+    } else {
+      last_price = new_price;
+    }
+
+    vwap.amend(old_price, old_volume, new_price, new_volume, ts);
+  }
+
+  /**
+   * @brief Rebuilds the EMA from a checkpoint by replaying prices
+   * @param checkpoint Series state captured before the replayed prices
+   * @param prices Prices of every trade after the checkpoint, in order
+   *
+   * Mirrors update(): the first price of a series only seeds last_price.
+   */
+  template <typename Prices>
+  void replay_ema(const Series &checkpoint, const Prices &prices) {
+    ema = checkpoint.ema;
+    double previous = checkpoint.last_price;
+    for (double price : prices) {
+      if (previous != 0) {
+        ema.update(price);
+      }
+      previous = price;
+    }
+  }
+
+  /**
+   * @brief Returns the most recent price seen (0.0 before the first update)
+   */
+  double get_last_price() const { return last_price; }
+
+  /**
+   * @brief Serializes every indicator's state (for snapshot indexes)
+   * @param out Binary output stream
+   *
+   * Indicator parameters (windows, alpha) are not written; the reader must
+   * construct the Series with the same parameters before calling load().
+   */
+  void save(std::ostream &out) const {
+    sma.save(out);
+    ema.save(out);
+    volatility.save(out);
+    vwap.save(out);
+    write_binary(out, last_price);
+  }
+
+  /**
+   * @brief Restores state written by save()
+   * @param in Binary input stream
+   * @return true on success
+   */
+  bool load(std::istream &in) {
+    return sma.load(in) && ema.load(in) && volatility.load(in) &&
+           vwap.load(in) && read_binary(in, last_price);
+  }
+
   /**
    * @brief Retrieves the current value of a specific indicator
    * @param type The indicator type to query (SMA, EMA, VOLATILITY, or VWAP)
@@ -355,6 +952,25 @@ public:
       throw std::invalid_argument("Unknown Indicator Type");
     }
   }
+
+private:
+  /**
+   * @brief Writes the current indicator values to row i of the outputs
+   */
+  void store_values(const OutputSpans &out, size_t i) const {
+    if (!out.sma.empty()) {
+      out.sma[i] = sma.get_value();
+    }
+    if (!out.ema.empty()) {
+      out.ema[i] = ema.get_value();
+    }
+    if (!out.volatility.empty()) {
+      out.volatility[i] = volatility.get_value();
+    }
+    if (!out.vwap.empty()) {
+      out.vwap[i] = vwap.get_value();
+    }
+  }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,346 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @enum LatencyStage
+ * @brief Pipeline stages whose per-row latency is recorded
+ *
+ * Every row that reaches the output is timed from the moment its bytes became
+ * available (the line was read) to the moment it was emitted. The total is
+ * broken down into the stages below.
+ */
+enum class LatencyStage {
+  PARSE,  ///< Splitting the line and converting numeric fields
+  HOLD,   ///< Time spent in the reorder buffer (--max-lateness only)
+  UPDATE, ///< Symbol lookup and indicator updates
+  OUTPUT, ///< Formatting and writing the output row
+  TOTAL,  ///< Bytes available to row emitted
+  COUNT   ///< Number of stages (not a real stage)
+};
+
+/**
+ * @brief Returns the display name of a latency stage
+ * @param stage The stage to name
+ * @return Short lowercase name used in reports
+ */
+inline const char *latency_stage_name(LatencyStage stage) {
+  switch (stage) {
+  case LatencyStage::PARSE:
+    return "parse";
+  case LatencyStage::HOLD:
+    return "hold";
+  case LatencyStage::UPDATE:
+    return "update";
+  case LatencyStage::OUTPUT:
+    return "output";
+  case LatencyStage::TOTAL:
+    return "total";
+  default:
+    return "?";
+  }
+}
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style log-linear histogram of nanosecond latencies
+ *
+ * Values below 2^SUB_BITS are counted exactly. Larger values are grouped by
+ * their most significant bit and then split linearly into 2^SUB_BITS
+ * sub-buckets, so every bucket is within ~3% of the values it holds while the
+ * whole 64-bit range fits into under 2000 counters.
+ *
+ * A histogram has a single writer (the thread that owns it). Counters are
+ * relaxed atomics written with plain load/store pairs, so recording never
+ * takes a lock or a locked instruction, while a reporting thread may read
+ * them at any time.
+ */
+class LatencyHistogram {
+public:
+  static constexpr int SUB_BITS = 5; ///< log2 of sub-buckets per power of two
+  static constexpr size_t SUB_COUNT = size_t{1} << SUB_BITS;
+  static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> counts{}; ///< Per-bucket counts
+  std::atomic<uint64_t> max_value{0}; ///< Largest value ever recorded
+
+public:
+  /**
+   * @brief Maps a value to its bucket index
+   * @param value Latency in nanoseconds
+   * @return Index into the counts array
+   */
+  static size_t bucket_index(uint64_t value) {
+    if (value < 2 * SUB_COUNT) {
+      return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BITS;
+    uint64_t top = value >> shift; // in [SUB_COUNT, 2 * SUB_COUNT)
+    return static_cast<size_t>(shift + 1) * SUB_COUNT + (top - SUB_COUNT);
+  }
+
+  /**
+   * @brief Returns the largest value that maps to a bucket
+   * @param index Bucket index
+   * @return Highest value equivalent to the bucket (used for percentiles)
+   */
+  static uint64_t bucket_upper(size_t index) {
+    if (index < 2 * SUB_COUNT) {
+      return index;
+    }
+    size_t shift = index / SUB_COUNT - 1;
+    uint64_t top = SUB_COUNT + (index % SUB_COUNT);
+    return ((top + 1) << shift) - 1;
+  }
+
+  /**
+   * @brief Records one latency sample (owner thread only)
+   * @param value Latency in nanoseconds
+   */
+  void record(uint64_t value) {
+    auto &slot = counts[bucket_index(value)];
+    slot.store(slot.load(std::memory_order_relaxed) + 1,
+               std::memory_order_relaxed);
+    if (value > max_value.load(std::memory_order_relaxed)) {
+      max_value.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Reads the count of a bucket (safe from any thread)
+   * @param index Bucket index
+   */
+  uint64_t count_at(size_t index) const {
+    return counts[index].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the largest value recorded so far (safe from any thread)
+   */
+  uint64_t max() const { return max_value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @struct LatencySummary
+ * @brief Percentiles extracted from a merged set of bucket counts
+ */
+struct LatencySummary {
+  uint64_t count = 0; ///< Number of samples
+  uint64_t p50 = 0;   ///< Median latency (ns)
+  uint64_t p99 = 0;   ///< 99th percentile latency (ns)
+  uint64_t p999 = 0;  ///< 99.9th percentile latency (ns)
+  uint64_t max = 0;   ///< Maximum latency (ns)
+};
+
+/**
+ * @class LatencyRecorder
+ * @brief Collects per-thread, per-stage latency histograms and reports them
+ *
+ * Each thread that records gets its own set of histograms on first use, so
+ * the hot path never shares a cache line with another writer. Reports merge
+ * every thread's histograms on the fly. Periodic reports cover only the
+ * samples recorded since the previous report (computed by diffing against the
+ * last merged snapshot, so writers never have to reset anything); the final
+ * report covers the whole run.
+ */
+class LatencyRecorder {
+  using StageHistograms =
+      std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::COUNT)>;
+  using Snapshot = std::vector<uint64_t>;
+
+  std::mutex registry_mutex; ///< Guards thread registration and reporting
+  std::vector<std::unique_ptr<StageHistograms>> per_thread; ///< One per thread
+  std::unordered_map<std::thread::id, StageHistograms *>
+      by_thread; ///< Each registered thread's histograms
+  std::array<Snapshot, static_cast<size_t>(LatencyStage::COUNT)>
+      last_report; ///< Merged counts at the previous periodic report
+  uint64_t id = next_id(); ///< Never reused, unlike the recorder's address
+
+  /**
+   * @brief Returns a new recorder id (ids start at 1)
+   */
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> last{0};
+    return last.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  /**
+   * @brief Sums one stage's bucket counts over every registered thread
+   * @param stage Stage index
+   * @param max_out Receives the largest max() over all threads
+   */
+  Snapshot merge(size_t stage, uint64_t &max_out) {
+    Snapshot merged(LatencyHistogram::BUCKETS, 0);
+    max_out = 0;
+    for (const auto &hists : per_thread) {
+      const LatencyHistogram &h = (*hists)[stage];
+      for (size_t i = 0; i < merged.size(); ++i) {
+        merged[i] += h.count_at(i);
+      }
+      max_out = std::max(max_out, h.max());
+    }
+    return merged;
+  }
+
+  /**
+   * @brief Extracts percentiles from merged bucket counts
+   * @param counts Merged counts
+   * @param max_value Exact maximum, or 0 to use the highest non-empty bucket
+   */
+  static LatencySummary summarize(const Snapshot &counts, uint64_t max_value) {
+    LatencySummary s;
+    for (uint64_t c : counts) {
+      s.count += c;
+    }
+    if (s.count == 0) {
+      return s;
+    }
+
+    // Rank of each percentile (1-based, rounded up)
+    const uint64_t r50 = (s.count * 500 + 999) / 1000;
+    const uint64_t r99 = (s.count * 990 + 999) / 1000;
+    const uint64_t r999 = (s.count * 999 + 999) / 1000;
+
+    uint64_t seen = 0;
+    size_t highest = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+      if (counts[i] == 0)
+        continue;
+      uint64_t before = seen;
+      seen += counts[i];
+      uint64_t value = LatencyHistogram::bucket_upper(i);
+      if (before < r50 && seen >= r50)
+        s.p50 = value;
+      if (before < r99 && seen >= r99)
+        s.p99 = value;
+      if (before < r999 && seen >= r999)
+        s.p999 = value;
+      highest = i;
+    }
+    s.max =
+        max_value != 0 ? max_value : LatencyHistogram::bucket_upper(highest);
+
+    // Bucket upper bounds may overshoot the exact maximum; clamp to it
+    s.p50 = std::min(s.p50, s.max);
+    s.p99 = std::min(s.p99, s.max);
+    s.p999 = std::min(s.p999, s.max);
+    return s;
+  }
+
+  /**
+   * @brief Prints one table of per-stage summaries
+   */
+  static void print_table(
+      std::ostream &out, const char *label,
+      const std::array<LatencySummary, static_cast<size_t>(LatencyStage::COUNT)>
+          &rows) {
+    out << "[latency] " << label << " rows="
+        << rows[static_cast<size_t>(LatencyStage::TOTAL)].count << '\n';
+    out << "[latency]   " << std::left << std::setw(8) << "stage" << std::right
+        << std::setw(12) << "p50(ns)" << std::setw(12) << "p99(ns)"
+        << std::setw(12) << "p99.9(ns)" << std::setw(12) << "max(ns)" << '\n';
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const LatencySummary &s = rows[i];
+      if (s.count == 0 && i != static_cast<size_t>(LatencyStage::TOTAL))
+        continue; // Stage not active in this run
+      out << "[latency]   " << std::left << std::setw(8)
+          << latency_stage_name(static_cast<LatencyStage>(i)) << std::right
+          << std::setw(12) << s.p50 << std::setw(12) << s.p99 << std::setw(12)
+          << s.p999 << std::setw(12) << s.max << '\n';
+    }
+  }
+
+public:
+  LatencyRecorder() {
+    for (auto &snap : last_report) {
+      snap.assign(LatencyHistogram::BUCKETS, 0);
+    }
+  }
+
+  /**
+   * @brief Returns the calling thread's histograms, registering them once
+   *
+   * Callers on a hot path should fetch this reference once and keep it.
+   * The thread remembers the last recorder it used, keyed on the recorder's
+   * id rather than its address (which a later recorder may reuse); a thread
+   * switching between recorders looks itself up in the recorder's registry
+   * instead of registering again.
+   */
+  StageHistograms &local() {
+    thread_local StageHistograms *mine = nullptr;
+    thread_local uint64_t owner = 0;
+    if (owner != id) {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      StageHistograms *&registered = by_thread[std::this_thread::get_id()];
+      if (registered == nullptr) {
+        per_thread.push_back(std::make_unique<StageHistograms>());
+        registered = per_thread.back().get();
+      }
+      mine = registered;
+      owner = id;
+    }
+    return *mine;
+  }
+
+  /**
+   * @brief Prints percentiles for samples recorded since the last call
+   * @param out Stream to write the report to (normally std::cerr)
+   */
+  void report_interval(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::array<LatencySummary, static_cast<size_t>(LatencyStage::COUNT)> rows;
+    for (size_t stage = 0; stage < rows.size(); ++stage) {
+      uint64_t ignored_max;
+      Snapshot merged = merge(stage, ignored_max);
+      Snapshot delta(merged.size());
+      for (size_t i = 0; i < merged.size(); ++i) {
+        delta[i] = merged[i] - last_report[stage][i];
+      }
+      rows[stage] = summarize(delta, 0);
+      last_report[stage] = std::move(merged);
+    }
+    print_table(out, "interval", rows);
+  }
+
+  /**
+   * @brief Prints percentiles over every sample recorded during the run
+   * @param out Stream to write the report to (normally std::cerr)
+   */
+  void report_total(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::array<LatencySummary, static_cast<size_t>(LatencyStage::COUNT)> rows;
+    for (size_t stage = 0; stage < rows.size(); ++stage) {
+      uint64_t max_value;
+      Snapshot merged = merge(stage, max_value);
+      rows[stage] = summarize(merged, max_value);
+    }
+    print_table(out, "total", rows);
+  }
+};
+
+/**
+ * @brief Reads the monotonic clock used for latency measurements
+ * @return Nanoseconds since an arbitrary fixed point
+ */
+inline uint64_t latency_now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef PRICEANALYTICS_H
+#define PRICEANALYTICS_H
+
+/*
+ * C API of libpriceanalytics, for callers that cannot use the C++ Engine
+ * class directly (Python via ctypes or cffi, other languages' FFIs).
+ *
+ * Results accumulate in contiguous columns owned by the engine, one array
+ * per column, so a caller can wrap them without copying:
+ *
+ *   pa_engine *engine = pa_engine_create("--sma=20 --vwap=daily");
+ *   pa_engine_process_file(engine, "trades.csv");
+ *   const void *data;
+ *   size_t rows;
+ *   pa_result_column(engine, PA_COLUMN_SMA, &data, &rows);
+ *   ... (const double *)data holds rows values ...
+ *   pa_engine_destroy(engine);
+ *
+ * Functions returning int return 0 on success and -1 on failure; after a
+ * failure pa_last_error() describes it. No function throws or aborts.
+ * Compatible changes only add functions and column ids; PA_API_VERSION
+ * changes if an existing signature or column type ever has to change.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PA_API_VERSION 1
+
+/**
+ * @brief Opaque engine handle
+ */
+typedef struct pa_engine pa_engine;
+
+/**
+ * @brief Result columns and their element types
+ */
+typedef enum pa_column {
+  PA_COLUMN_TIMESTAMP = 0,  /**< int64_t ns since the epoch (INT64_MIN if the
+                                 timestamp was not YYYY-MM-DD HH:MM:SS) */
+  PA_COLUMN_SYMBOL = 1,     /**< uint32_t id, see pa_symbol_name() */
+  PA_COLUMN_PRICE = 2,      /**< double */
+  PA_COLUMN_VOLUME = 3,     /**< int64_t */
+  PA_COLUMN_SMA = 4,        /**< double (only with --sma) */
+  PA_COLUMN_EMA = 5,        /**< double (only with --ema) */
+  PA_COLUMN_VOLATILITY = 6, /**< double (only with --vol) */
+  PA_COLUMN_VWAP = 7,       /**< double (only with --vwap) */
+  PA_COLUMN_ZSCORE = 8      /**< double (only with --pair; 0 on rows that
+                                 are not a pair's) */
+} pa_column;
+
+/**
+ * @brief Returns PA_API_VERSION of the library actually loaded
+ */
+int pa_api_version(void);
+
+/**
+ * @brief Creates an engine
+ * @param flags The analyzer's command-line flags separated by spaces, e.g.
+ * "--sma=20 --ema=50 --symbol=AAPL"; NULL or "" for the defaults
+ * @return The engine, or NULL if the flags are invalid
+ */
+pa_engine *pa_engine_create(const char *flags);
+
+/**
+ * @brief Destroys an engine and its result columns (NULL is ignored)
+ */
+void pa_engine_destroy(pa_engine *engine);
+
+/**
+ * @brief Processes a whole CSV file and ends the input
+ * @return 0 on success, -1 if the file cannot be read
+ */
+int pa_engine_process_file(pa_engine *engine, const char *path);
+
+/**
+ * @brief Processes a chunk of CSV bytes; lines may straddle chunks
+ */
+int pa_engine_push(pa_engine *engine, const char *data, size_t length);
+
+/**
+ * @brief Ends pushed input (processes an unterminated last line and rows
+ * held by --max-lateness)
+ */
+int pa_engine_finish(pa_engine *engine);
+
+/**
+ * @brief Returns the number of result rows currently held
+ */
+size_t pa_result_rows(const pa_engine *engine);
+
+/**
+ * @brief Returns a result column as a contiguous array owned by the engine
+ * @param data Receives a pointer to the first element
+ * @param length Receives the number of elements (pa_result_rows())
+ * @return 0 on success, -1 if the column id is unknown or the indicator is
+ * not enabled
+ *
+ * The pointer stays valid until the next call that adds or clears rows
+ * (pa_engine_push, pa_engine_finish, pa_engine_process_file,
+ * pa_result_clear) or destroys the engine.
+ */
+int pa_result_column(const pa_engine *engine, pa_column column,
+                     const void **data, size_t *length);
+
+/**
+ * @brief Drops the rows held so far (indicator state is kept), so long
+ * streams can be consumed in pieces
+ */
+void pa_result_clear(pa_engine *engine);
+
+/**
+ * @brief Returns the number of distinct symbols seen
+ */
+size_t pa_symbol_count(const pa_engine *engine);
+
+/**
+ * @brief Returns the NUL-terminated name of a symbol id, or NULL if unknown
+ *
+ * Names stay valid until the engine is destroyed.
+ */
+const char *pa_symbol_name(const pa_engine *engine, uint32_t id);
+
+/**
+ * @brief Describes the last failure on the calling thread ("" if none)
+ */
+const char *pa_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
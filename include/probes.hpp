@@ -0,0 +1,43 @@
+#ifndef PROBES_HPP
+#define PROBES_HPP
+
+/*
+ * USDT (user-level statically defined tracing) probes on hot paths.
+ *
+ * When <sys/sdt.h> is available (systemtap-sdt-dev / systemtap-sdt-devel),
+ * each probe compiles to a single nop plus a note in the ELF file, so an
+ * unattached probe costs nothing measurable. bpftrace, perf or SystemTap can
+ * attach to a running analyzer without a rebuild or restart:
+ *
+ *   bpftrace -e 'usdt:./analyzer:analyzer:symbol_created
+ *                { printf("%s\n", str(arg0)); }'
+ *
+ * Without the header, or with -DANALYZER_NO_PROBES, the macros expand to
+ * nothing and their arguments are not evaluated.
+ *
+ * Probes (provider "analyzer"):
+ *   batch_read(rows, input_offset, drained)
+ *   row_parsed(symbol, timestamp, volume)
+ *   row_rejected(line, line_length, input_offset)
+ *   symbol_created(symbol, symbols)
+ *   indicator_updated(symbol, timestamp, volume)
+ *   output_flush(bytes, rows, flushed)
+ *
+ * Strings are NUL-terminated char pointers, except row_rejected's line,
+ * which comes with its length. Prices are not passed because bpftrace
+ * cannot read floating-point probe arguments.
+ */
+
+#if __has_include(<sys/sdt.h>) && !defined(ANALYZER_NO_PROBES)
+#include <sys/sdt.h>
+#define ANALYZER_HAS_PROBES 1
+#define ANALYZER_PROBE2(name, a1, a2) DTRACE_PROBE2(analyzer, name, a1, a2)
+#define ANALYZER_PROBE3(name, a1, a2, a3)                                      \
+  DTRACE_PROBE3(analyzer, name, a1, a2, a3)
+#else
+#define ANALYZER_HAS_PROBES 0
+#define ANALYZER_PROBE2(name, a1, a2) ((void)0)
+#define ANALYZER_PROBE3(name, a1, a2, a3) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_HAS_TSC 1
+#else
+#define PROFILE_HAS_TSC 0
+#endif
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PROFILE_HAS_PERF_EVENTS 1
+#else
+#define PROFILE_HAS_PERF_EVENTS 0
+#endif
+
+/**
+ * @enum ProfileStage
+ * @brief Stages of the batched processing pipeline timed by --profile
+ */
+enum class ProfileStage {
+  READ,   ///< Reading lines from the input stream
+  SPLIT,  ///< Splitting lines into fields
+  PARSE,  ///< Converting fields to timestamps, symbols and numbers
+  LOOKUP, ///< Symbol filtering and per-symbol state lookup
+  UPDATE, ///< Indicator updates (and reordering/corrections when enabled)
+  FORMAT, ///< Formatting output rows
+  WRITE,  ///< Writing formatted rows to standard output
+  COUNT   ///< Number of stages (not a real stage)
+};
+
+/**
+ * @brief Returns the display name of a profiled stage
+ * @param stage The stage to name
+ * @return Short lowercase name used in reports
+ */
+inline const char *profile_stage_name(ProfileStage stage) {
+  switch (stage) {
+  case ProfileStage::READ:
+    return "read";
+  case ProfileStage::SPLIT:
+    return "split";
+  case ProfileStage::PARSE:
+    return "parse";
+  case ProfileStage::LOOKUP:
+    return "lookup";
+  case ProfileStage::UPDATE:
+    return "update";
+  case ProfileStage::FORMAT:
+    return "format";
+  case ProfileStage::WRITE:
+    return "write";
+  default:
+    return "?";
+  }
+}
+
+/**
+ * @brief Reads the profiling clock
+ * @return Time stamp counter ticks on x86, steady-clock nanoseconds elsewhere
+ *
+ * The TSC runs at a constant rate on every CPU the analyzer targets, so tick
+ * deltas are reported as cycles at the nominal frequency.
+ */
+inline uint64_t profile_ticks() {
+#if PROFILE_HAS_TSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+/**
+ * @enum HardwareEvent
+ * @brief Hardware counters read around each stage by --profile=hw
+ */
+enum class HardwareEvent {
+  CYCLES,        ///< Core cycles (actual, not TSC)
+  INSTRUCTIONS,  ///< Retired instructions
+  L1D_MISSES,    ///< L1 data cache read misses
+  LLC_MISSES,    ///< Last-level cache misses
+  BRANCH_MISSES, ///< Mispredicted branches
+  DTLB_MISSES,   ///< Data TLB read misses
+  COUNT          ///< Number of events (not a real event)
+};
+
+/**
+ * @brief Returns the report column name of a hardware event
+ */
+inline const char *hardware_event_name(HardwareEvent event) {
+  switch (event) {
+  case HardwareEvent::CYCLES:
+    return "cycles";
+  case HardwareEvent::INSTRUCTIONS:
+    return "instr";
+  case HardwareEvent::L1D_MISSES:
+    return "L1d-miss";
+  case HardwareEvent::LLC_MISSES:
+    return "LLC-miss";
+  case HardwareEvent::BRANCH_MISSES:
+    return "br-miss";
+  case HardwareEvent::DTLB_MISSES:
+    return "dTLB-miss";
+  default:
+    return "?";
+  }
+}
+
+/**
+ * @class HardwareCounters
+ * @brief Per-stage hardware counter totals read through perf_event_open
+ *
+ * Each event is opened on its own (user space only, this thread) rather than
+ * as one group, so the kernel can multiplex them when the PMU has fewer
+ * counters than events; every reading is scaled by time enabled / time
+ * running. Events the CPU or the perf_event_paranoid setting does not allow
+ * are skipped and reported as n/a.
+ */
+class HardwareCounters {
+  static constexpr size_t EVENTS = static_cast<size_t>(HardwareEvent::COUNT);
+  static constexpr size_t STAGES = static_cast<size_t>(ProfileStage::COUNT);
+
+  std::array<int, EVENTS> fds;        ///< Event descriptors (-1 = n/a)
+  std::array<double, EVENTS> last{};  ///< Scaled counts at the last lap
+  std::array<std::array<double, EVENTS>, STAGES> totals{}; ///< Per stage
+  bool active = false; ///< At least one event is being counted
+
+#if PROFILE_HAS_PERF_EVENTS
+  /**
+   * @brief Fills in the perf type and config of an event
+   */
+  static void describe(HardwareEvent event, perf_event_attr &attr) {
+    auto cache = [](uint64_t cache_id) {
+      return cache_id | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case HardwareEvent::CYCLES:
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case HardwareEvent::INSTRUCTIONS:
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case HardwareEvent::L1D_MISSES:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = cache(PERF_COUNT_HW_CACHE_L1D);
+      break;
+    case HardwareEvent::LLC_MISSES:
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case HardwareEvent::BRANCH_MISSES:
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    case HardwareEvent::DTLB_MISSES:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = cache(PERF_COUNT_HW_CACHE_DTLB);
+      break;
+    default:
+      break;
+    }
+  }
+
+  /**
+   * @brief Reads an event's count scaled for multiplexing
+   */
+  static double read_scaled(int fd) {
+    uint64_t values[3]; // value, time enabled, time running
+    if (::read(fd, values, sizeof(values)) != sizeof(values) ||
+        values[2] == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(values[0]) * values[1] / values[2];
+  }
+#endif
+
+public:
+  HardwareCounters() { fds.fill(-1); }
+  HardwareCounters(const HardwareCounters &) = delete;
+  HardwareCounters &operator=(const HardwareCounters &) = delete;
+
+  ~HardwareCounters() {
+#if PROFILE_HAS_PERF_EVENTS
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+#endif
+  }
+
+  /**
+   * @brief Opens every event for the calling thread
+   * @param error Receives the reason if no event could be opened
+   * @return true if at least one event is counted
+   */
+  bool open(std::string &error) {
+#if PROFILE_HAS_PERF_EVENTS
+    int first_errno = 0;
+    for (size_t i = 0; i < EVENTS; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      describe(static_cast<HardwareEvent>(i), attr);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds[i] = static_cast<int>(
+          ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fds[i] < 0 && first_errno == 0) {
+        first_errno = errno;
+      }
+      active = active || fds[i] >= 0;
+    }
+    if (!active) {
+      error = std::string("perf_event_open failed: ") +
+              std::strerror(first_errno) +
+              " (no PMU access, or kernel.perf_event_paranoid too high)";
+      return false;
+    }
+    for (size_t i = 0; i < EVENTS; ++i) {
+      last[i] = fds[i] >= 0 ? read_scaled(fds[i]) : 0.0;
+    }
+    return true;
+#else
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Charges counts since the previous lap to a stage
+   */
+  void lap(ProfileStage stage) {
+#if PROFILE_HAS_PERF_EVENTS
+    if (!active) {
+      return;
+    }
+    auto &stage_totals = totals[static_cast<size_t>(stage)];
+    for (size_t i = 0; i < EVENTS; ++i) {
+      if (fds[i] < 0) {
+        continue;
+      }
+      double now = read_scaled(fds[i]);
+      stage_totals[i] += now - last[i];
+      last[i] = now;
+    }
+#else
+    (void)stage;
+#endif
+  }
+
+  /**
+   * @brief Whether any event is being counted
+   */
+  bool is_active() const { return active; }
+
+  /**
+   * @brief Prints per-row event counts and IPC for every stage
+   * @param out Stream to write the report to
+   * @param rows Rows processed (the per-row denominator)
+   */
+  void report(std::ostream &out, uint64_t rows) const {
+    const double per_row = rows > 0 ? 1.0 / rows : 0.0;
+    const size_t cycles = static_cast<size_t>(HardwareEvent::CYCLES);
+    const size_t instructions =
+        static_cast<size_t>(HardwareEvent::INSTRUCTIONS);
+
+    out << "[profile]   " << std::left << std::setw(8) << "stage"
+        << std::right;
+    for (size_t i = 0; i < EVENTS; ++i) {
+      out << std::setw(11)
+          << hardware_event_name(static_cast<HardwareEvent>(i));
+    }
+    out << std::setw(7) << "IPC" << "   (per row)\n";
+
+    std::array<double, EVENTS> sum{};
+    auto print_row = [&](const char *name,
+                         const std::array<double, EVENTS> &counts) {
+      out << "[profile]   " << std::left << std::setw(8) << name << std::right
+          << std::fixed;
+      for (size_t i = 0; i < EVENTS; ++i) {
+        if (fds[i] < 0) {
+          out << std::setw(11) << "n/a";
+        } else {
+          out << std::setw(11) << std::setprecision(2) << counts[i] * per_row;
+        }
+      }
+      if (fds[cycles] >= 0 && fds[instructions] >= 0 && counts[cycles] > 0) {
+        out << std::setw(7) << std::setprecision(2)
+            << counts[instructions] / counts[cycles];
+      } else {
+        out << std::setw(7) << "n/a";
+      }
+      out << '\n';
+    };
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+      print_row(profile_stage_name(static_cast<ProfileStage>(stage)),
+                totals[stage]);
+      for (size_t i = 0; i < EVENTS; ++i) {
+        sum[i] += totals[stage][i];
+      }
+    }
+    print_row("total", sum);
+  }
+};
+
+/**
+ * @class StageProfiler
+ * @brief Accumulates clock ticks per pipeline stage
+ *
+ * The pipeline calls lap() once per stage per batch rather than per row, so
+ * the overhead is a handful of clock reads per few thousand rows. Tick counts
+ * are converted to nanoseconds by comparing the total ticks with the
+ * steady-clock time elapsed over the same run. With hardware counters
+ * enabled, every lap also reads the perf events (a few syscalls per batch).
+ */
+class StageProfiler {
+  std::array<uint64_t, static_cast<size_t>(ProfileStage::COUNT)> ticks{};
+  uint64_t mark = 0;        ///< Clock value at the end of the last lap
+  uint64_t start_ticks = 0; ///< Clock value when profiling started
+  std::chrono::steady_clock::time_point start_time; ///< Wall time at start
+  uint64_t rows = 0;                                ///< Input rows processed
+  uint64_t batches = 0;                             ///< Batches processed
+  HardwareCounters hardware; ///< Optional perf counters (--profile=hw)
+
+public:
+  /**
+   * @brief Starts the clock; the next lap() is measured from here
+   * @param with_hardware Also count hardware events on the calling thread
+   * @param warnings Where to explain why hardware counters are unavailable
+   *
+   * Without access to hardware counters the profiler falls back to timing
+   * only, so --profile=hw never fails a run.
+   */
+  void start(bool with_hardware, std::ostream &warnings) {
+    std::string error;
+    if (with_hardware && !hardware.open(error)) {
+      warnings << "Warning: " << error << "; profiling time only\n";
+    }
+    start_time = std::chrono::steady_clock::now();
+    start_ticks = mark = profile_ticks();
+  }
+
+  /**
+   * @brief Charges the time since the previous lap to a stage
+   * @param stage The stage that just finished
+   */
+  void lap(ProfileStage stage) {
+    uint64_t now = profile_ticks();
+    ticks[static_cast<size_t>(stage)] += now - mark;
+    hardware.lap(stage);
+    // Restart after the counter reads so their cost is not charged onward
+    mark = hardware.is_active() ? profile_ticks() : now;
+  }
+
+  /**
+   * @brief Counts a processed batch
+   * @param batch_rows Input rows in the batch
+   */
+  void count_batch(size_t batch_rows) {
+    rows += batch_rows;
+    batches++;
+  }
+
+  /**
+   * @brief Prints cycles per row, ns per row and share of total per stage
+   * @param out Stream to write the report to (normally std::cerr)
+   */
+  void report(std::ostream &out) const {
+    const uint64_t elapsed_ticks = profile_ticks() - start_ticks;
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(
+                                  std::chrono::steady_clock::now() - start_time)
+                                  .count();
+    const double ns_per_tick =
+        elapsed_ticks > 0 ? elapsed_ns / elapsed_ticks : 0.0;
+    const double per_row = rows > 0 ? 1.0 / rows : 0.0;
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    uint64_t total = 0;
+    for (uint64_t t : ticks) {
+      total += t;
+    }
+
+    out << "[profile] rows=" << rows << " batches=" << batches << '\n';
+    out << "[profile]   " << std::left << std::setw(8) << "stage" << std::right
+        << std::setw(14) << (PROFILE_HAS_TSC ? "cycles/row" : "ticks/row")
+        << std::setw(12) << "ns/row" << std::setw(10) << "share" << '\n';
+    auto print_row = [&](const char *name, uint64_t stage_ticks) {
+      out << "[profile]   " << std::left << std::setw(8) << name << std::right
+          << std::fixed << std::setprecision(1) << std::setw(14)
+          << stage_ticks * per_row << std::setw(12)
+          << stage_ticks * per_row * ns_per_tick << std::setw(9)
+          << (total > 0 ? 100.0 * stage_ticks / total : 0.0) << "%\n";
+    };
+    for (size_t i = 0; i < ticks.size(); ++i) {
+      print_row(profile_stage_name(static_cast<ProfileStage>(i)), ticks[i]);
+    }
+    print_row("total", total);
+    if (hardware.is_active()) {
+      hardware.report(out, rows);
+    }
+    out.flags(flags);
+    out.precision(precision);
+  }
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/**
+ * @struct ProgressCounters
+ * @brief Counters the processing thread publishes once per batch
+ *
+ * Written with relaxed stores by the processing thread and read by the
+ * progress thread; the values only need to be individually recent, not
+ * mutually consistent.
+ */
+struct ProgressCounters {
+  std::atomic<uint64_t> bytes{0};    ///< Input bytes consumed
+  std::atomic<uint64_t> rows{0};     ///< Non-empty lines read
+  std::atomic<uint64_t> failures{0}; ///< Lines that failed to parse
+  std::atomic<uint64_t> symbols{0};  ///< Distinct symbols seen
+};
+
+/**
+ * @brief Returns the lock every writer of diagnostics to a shared stream
+ * holds while writing
+ *
+ * std::cerr is unsynchronized once sync_with_stdio(false) has been called,
+ * so the progress thread and the processing thread (latency reports,
+ * warnings) take turns through this mutex.
+ */
+inline std::mutex &diagnostics_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * @brief Formats a byte count with a binary-ish unit (e.g. "1.2 GB")
+ */
+inline std::string format_bytes(double bytes) {
+  const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+  int unit = 0;
+  while (bytes >= 1024.0 && unit < 4) {
+    bytes /= 1024.0;
+    unit++;
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", bytes,
+                units[unit]);
+  return text;
+}
+
+/**
+ * @brief Formats a duration in seconds as e.g. "1h02m", "3m25s" or "12s"
+ */
+inline std::string format_eta(double seconds) {
+  uint64_t s = static_cast<uint64_t>(seconds + 0.5);
+  char text[32];
+  if (s >= 3600) {
+    std::snprintf(text, sizeof(text), "%luh%02lum",
+                  static_cast<unsigned long>(s / 3600),
+                  static_cast<unsigned long>(s / 60 % 60));
+  } else if (s >= 60) {
+    std::snprintf(text, sizeof(text), "%lum%02lus",
+                  static_cast<unsigned long>(s / 60),
+                  static_cast<unsigned long>(s % 60));
+  } else {
+    std::snprintf(text, sizeof(text), "%lus", static_cast<unsigned long>(s));
+  }
+  return text;
+}
+
+/**
+ * @class ProgressReporter
+ * @brief Timer thread that prints throughput and progress to a stream
+ *
+ * Every interval it prints bytes processed (and the percentage and ETA when
+ * the input size is known), rows/s and MB/s over the last interval, distinct
+ * symbols and the parse-failure rate. The processing thread never waits on
+ * it: all it does is publish counters.
+ */
+class ProgressReporter {
+  using clock = std::chrono::steady_clock;
+
+  const ProgressCounters &counters; ///< Published by the processing thread
+  uint64_t total_bytes;             ///< Input size, or 0 if unknown
+  std::chrono::nanoseconds interval;
+  std::ostream &out;
+  TraceRecorder *trace; ///< Records each report as a span, if set
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  std::thread thread;
+
+  clock::time_point start_time;
+  clock::time_point last_time;
+  uint64_t last_bytes = 0;
+  uint64_t last_rows = 0;
+
+  /**
+   * @brief Prints one progress line (written with a single call)
+   */
+  void print(bool final_line) {
+    const clock::time_point now = clock::now();
+    const uint64_t bytes = counters.bytes.load(std::memory_order_relaxed);
+    const uint64_t rows = counters.rows.load(std::memory_order_relaxed);
+    const uint64_t failures = counters.failures.load(std::memory_order_relaxed);
+    const uint64_t symbols = counters.symbols.load(std::memory_order_relaxed);
+
+    // Final lines report whole-run averages, periodic lines the last interval
+    const clock::time_point since = final_line ? start_time : last_time;
+    const uint64_t base_bytes = final_line ? 0 : last_bytes;
+    const uint64_t base_rows = final_line ? 0 : last_rows;
+    const double seconds = std::chrono::duration<double>(now - since).count();
+    const double rows_per_s = seconds > 0 ? (rows - base_rows) / seconds : 0;
+    const double mb_per_s =
+        seconds > 0 ? (bytes - base_bytes) / seconds / (1024.0 * 1024.0) : 0;
+
+    std::string line = "[progress] " + format_bytes(bytes);
+    char text[128];
+    if (total_bytes > 0) {
+      std::snprintf(text, sizeof(text), " / %s (%.1f%%)",
+                    format_bytes(total_bytes).c_str(),
+                    100.0 * bytes / total_bytes);
+      line += text;
+    }
+    std::snprintf(text, sizeof(text), "  %.2f Mrows/s  %.1f MB/s",
+                  rows_per_s / 1e6, mb_per_s);
+    line += text;
+
+    const double elapsed =
+        std::chrono::duration<double>(now - start_time).count();
+    if (!final_line && total_bytes > bytes && bytes > 0) {
+      line += "  ETA " + format_eta((total_bytes - bytes) * elapsed / bytes);
+    } else if (final_line) {
+      line += "  done in " + format_eta(elapsed);
+    }
+    std::snprintf(text, sizeof(text), "  symbols=%lu  failures=%.3f%%\n",
+                  static_cast<unsigned long>(symbols),
+                  rows > 0 ? 100.0 * failures / rows : 0.0);
+    line += text;
+    {
+      std::lock_guard<std::mutex> lock(diagnostics_mutex());
+      out.write(line.data(), static_cast<std::streamsize>(line.size()));
+      out.flush();
+    }
+
+    last_time = now;
+    last_bytes = bytes;
+    last_rows = rows;
+  }
+
+  void run() {
+    TraceBuffer *spans = trace ? &trace->local("progress") : nullptr;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+      const uint64_t begin = spans ? trace_now_ns() : 0;
+      print(false);
+      if (spans) {
+        spans->record("report", begin, trace_now_ns(), 0);
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Starts the timer thread
+   * @param published Counters updated by the processing thread
+   * @param input_bytes Total input size, or 0 if unknown (e.g. a pipe)
+   * @param interval_ns Time between reports
+   * @param stream Where reports go (normally std::cerr)
+   * @param recorder Trace to record each report in (--trace), or nullptr
+   */
+  ProgressReporter(const ProgressCounters &published, uint64_t input_bytes,
+                   int64_t interval_ns, std::ostream &stream,
+                   TraceRecorder *recorder = nullptr)
+      : counters(published), total_bytes(input_bytes), interval(interval_ns),
+        out(stream), trace(recorder), start_time(clock::now()),
+        last_time(start_time) {
+    thread = std::thread([this] { run(); });
+  }
+
+  ProgressReporter(const ProgressReporter &) = delete;
+  ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+  /**
+   * @brief Stops the thread and prints a final summary line
+   */
+  ~ProgressReporter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+    print(true);
+  }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include "csv.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+/**
+ * @struct PendingRow
+ * @brief A parsed row held back until the watermark passes it
+ */
+struct PendingRow {
+  int64_t ts_ns;         ///< Parsed timestamp (ordering key)
+  uint64_t seq;          ///< Arrival order, breaks timestamp ties stably
+  uint64_t available_ns; ///< When the row's bytes were read (latency)
+  uint64_t parsed_ns;    ///< When the row finished parsing (latency)
+  ParsedRow row;         ///< The row itself
+
+  /**
+   * @brief Heap ordering: true if this row should be released after other
+   */
+  bool operator>(const PendingRow &other) const {
+    if (ts_ns != other.ts_ns)
+      return ts_ns > other.ts_ns;
+    return seq > other.seq;
+  }
+};
+
+/**
+ * @class ReorderBuffer
+ * @brief Min-heap that restores timestamp order for late ticks
+ *
+ * Rows of every symbol are pushed in arrival order and released in
+ * timestamp order once the watermark (newest timestamp seen on any symbol
+ * minus the allowed lateness) has passed them. The watermark is global so
+ * that a symbol which stops trading has its rows released as the rest of
+ * the feed moves on, instead of holding them until the end of the input.
+ * Any row whose timestamp is already behind the watermark on arrival can no
+ * longer be placed in order and is rejected as late, whatever its symbol.
+ *
+ * Because released rows are always at or below the watermark and accepted
+ * rows are always at or above it, the release sequence is non-decreasing in
+ * timestamp. Push and release cost O(log k) for k buffered rows.
+ */
+class ReorderBuffer {
+  std::vector<PendingRow> heap; ///< Min-heap on (ts_ns, seq)
+  int64_t newest_ns =
+      std::numeric_limits<int64_t>::min(); ///< Newest timestamp seen
+
+  /**
+   * @brief Returns the current watermark for a given lateness
+   */
+  int64_t watermark(int64_t lateness_ns) const {
+    if (newest_ns == std::numeric_limits<int64_t>::min())
+      return newest_ns;
+    return newest_ns - lateness_ns;
+  }
+
+public:
+  /**
+   * @brief Offers a row to the buffer
+   * @param pending The row with its parsed timestamp and arrival sequence
+   * @param lateness_ns Maximum allowed lateness
+   * @return false if the row is later than the bound and was not buffered
+   */
+  bool push(PendingRow &&pending, int64_t lateness_ns) {
+    if (pending.ts_ns < watermark(lateness_ns)) {
+      return false;
+    }
+    newest_ns = std::max(newest_ns, pending.ts_ns);
+    heap.push_back(std::move(pending));
+    std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+    return true;
+  }
+
+  /**
+   * @brief Releases, in timestamp order, every row the watermark has passed
+   * @param lateness_ns Maximum allowed lateness
+   * @param emit Callable invoked with each released PendingRow&
+   */
+  template <typename Emit> void release(int64_t lateness_ns, Emit &&emit) {
+    const int64_t mark = watermark(lateness_ns);
+    while (!heap.empty() && heap.front().ts_ns <= mark) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+      emit(heap.back());
+      heap.pop_back();
+    }
+  }
+
+  /**
+   * @brief Applies a cancel or amend row to a trade that is still buffered
+   * @param ts_ns Timestamp of the trade being corrected
+   * @param correction The correction row (RowAction::CANCEL or AMEND)
+   * @return true if a buffered trade of the correction's symbol with that
+   * timestamp was corrected
+   *
+   * The most recently arrived trade with the timestamp is the one corrected,
+   * matching CorrectionLog. Costs O(k), which is fine for the small buffers
+   * a lateness bound produces.
+   */
+  bool correct(int64_t ts_ns, const ParsedRow &correction) {
+    size_t match = heap.size();
+    for (size_t i = 0; i < heap.size(); ++i) {
+      if (heap[i].ts_ns == ts_ns &&
+          heap[i].row.action == RowAction::TRADE &&
+          heap[i].row.symbol == correction.symbol &&
+          (match == heap.size() || heap[i].seq > heap[match].seq)) {
+        match = i;
+      }
+    }
+    if (match == heap.size()) {
+      return false;
+    }
+
+    if (correction.action == RowAction::AMEND) {
+      heap[match].row.price = correction.price;
+      heap[match].row.volume = correction.volume;
+    } else {
+      heap[match] = std::move(heap.back());
+      heap.pop_back();
+      std::make_heap(heap.begin(), heap.end(), std::greater<>{});
+    }
+    return true;
+  }
+
+  /**
+   * @brief Releases every buffered row, in timestamp order (end of input)
+   * @param emit Callable invoked with each released PendingRow&
+   */
+  template <typename Emit> void drain(Emit &&emit) {
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+      emit(heap.back());
+      heap.pop_back();
+    }
+  }
+
+  /**
+   * @brief Number of rows currently held
+   */
+  size_t size() const { return heap.size(); }
+};
+
+#endif
@@ -0,0 +1,360 @@
+#ifndef SINK_HPP
+#define SINK_HPP
+
+#include "binary_io.hpp"
+#include "csv.hpp"
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct ResultColumns
+ * @brief Which indicator columns a sink receives
+ */
+struct ResultColumns {
+  bool sma = false;        ///< SMA column present
+  bool ema = false;        ///< EMA column present
+  bool volatility = false; ///< Volatility column present
+  bool vwap = false;       ///< VWAP column present
+  bool zscore = false;     ///< Pair z-score column present (with --pair)
+
+  /**
+   * @brief Returns the columns selected by the output flags
+   */
+  static ResultColumns from_config(const CLIConfig &config) {
+    return {config.output_sma, config.output_ema, config.output_vol,
+            config.output_vwap, !config.pairs.empty()};
+  }
+};
+
+/**
+ * @struct ResultBatch
+ * @brief One batch of output rows, column by column
+ *
+ * Row i of the batch is element i of every column. Indicator columns that
+ * are not output are empty. Symbols are passed as ids into the symbols
+ * table, which holds every symbol seen so far: ids are assigned in order of
+ * first appearance and never change, so a sink only needs to look at the
+ * entries past the ones it has already seen.
+ *
+ * All views are only valid during the call they are passed to.
+ */
+struct ResultBatch {
+  size_t size = 0;                              ///< Rows in the batch
+  std::span<const std::string_view> timestamps; ///< As in the input
+  std::span<const uint32_t> symbol_ids;         ///< Index into symbols
+  std::span<const std::string_view> symbols;    ///< Symbol names by id
+  std::span<const double> prices;               ///< Trade prices
+  std::span<const int64_t> volumes;             ///< Trade volumes
+  std::span<const double> sma;                  ///< SMA after each row
+  std::span<const double> ema;                  ///< EMA after each row
+  std::span<const double> volatility;           ///< Volatility after each row
+  std::span<const double> vwap;                 ///< VWAP after each row
+  std::span<const double> zscore; ///< Pair spread z-score (0 for non-pairs)
+};
+
+/**
+ * @class ResultSink
+ * @brief Destination of the analyzer's output rows
+ *
+ * The pipeline hands every batch of output rows to write() and then calls
+ * commit(), so a sink can format in write() and emit everything in one call
+ * in commit(). Embedders implement this to consume typed columns directly,
+ * without formatting or re-parsing text.
+ */
+class ResultSink {
+public:
+  virtual ~ResultSink() = default;
+
+  /**
+   * @brief Called once before the first batch (e.g. to write a header)
+   */
+  virtual void begin(const ResultColumns &) {}
+
+  /**
+   * @brief Consumes a batch of rows
+   */
+  virtual void write(const ResultBatch &batch) = 0;
+
+  /**
+   * @brief Emits what write() produced since the last commit
+   * @param flush true if the destination should be flushed (the input has
+   * nothing more buffered, so a live consumer is waiting)
+   * @return Bytes emitted, or 0 for sinks that do not serialize
+   */
+  virtual size_t commit(bool) { return 0; }
+};
+
+/**
+ * @class CsvSink
+ * @brief Writes rows as CSV text with six-decimal values (the default)
+ */
+class CsvSink : public ResultSink {
+  std::ostream &out;  ///< Destination
+  std::string buffer; ///< Rows formatted since the last commit
+
+public:
+  explicit CsvSink(std::ostream &destination) : out(destination) {}
+
+  /**
+   * @brief Prints the header: base columns followed by the indicator columns
+   */
+  void begin(const ResultColumns &columns) override {
+    std::string header = "timestamp,symbol,price,volume";
+    if (columns.sma) {
+      header += ",sma";
+    }
+    if (columns.ema) {
+      header += ",ema";
+    }
+    if (columns.volatility) {
+      header += ",volatility";
+    }
+    if (columns.vwap) {
+      header += ",vwap";
+    }
+    if (columns.zscore) {
+      header += ",zscore";
+    }
+    out << header << '\n';
+  }
+
+  /**
+   * @brief Formats every row into the buffer, columns in header order
+   */
+  void write(const ResultBatch &batch) override {
+    for (size_t i = 0; i < batch.size; ++i) {
+      buffer += batch.timestamps[i];
+      buffer += ',';
+      buffer += batch.symbols[batch.symbol_ids[i]];
+      buffer += ',';
+      buffer += std::to_string(batch.prices[i]);
+      buffer += ',';
+      buffer += std::to_string(batch.volumes[i]);
+      if (!batch.sma.empty()) {
+        buffer += ',';
+        buffer += std::to_string(batch.sma[i]);
+      }
+      if (!batch.ema.empty()) {
+        buffer += ',';
+        buffer += std::to_string(batch.ema[i]);
+      }
+      if (!batch.volatility.empty()) {
+        buffer += ',';
+        buffer += std::to_string(batch.volatility[i]);
+      }
+      if (!batch.vwap.empty()) {
+        buffer += ',';
+        buffer += std::to_string(batch.vwap[i]);
+      }
+      if (!batch.zscore.empty()) {
+        buffer += ',';
+        buffer += std::to_string(batch.zscore[i]);
+      }
+      buffer += '\n';
+    }
+  }
+
+  size_t commit(bool flush) override {
+    const size_t bytes = buffer.size();
+    out.write(buffer.data(), static_cast<std::streamsize>(bytes));
+    if (flush) {
+      out.flush();
+    }
+    buffer.clear();
+    return bytes;
+  }
+};
+
+/**
+ * @brief Magic bytes at the start of every binary result stream
+ */
+inline constexpr char BINARY_RESULT_MAGIC[8] = {'P', 'A', 'R', 'E',
+                                                'S', '0', '0', '1'};
+
+/**
+ * @class BinarySink
+ * @brief Writes rows as native-endian binary columns (--output=binary)
+ *
+ * Layout: magic, one byte with the indicator columns present (bit 0 SMA,
+ * 1 EMA, 2 volatility, 3 VWAP, 4 pair z-score), then per batch:
+ *   - uint32 count of symbols first seen in this batch, each a
+ *     length-prefixed string (their ids continue from the previous batch)
+ *   - uint32 row count n
+ *   - n int64 timestamps in ns since the epoch (INT64_MIN if unparsable),
+ *     n uint32 symbol ids, n double prices, n int64 volumes, then n doubles
+ *     per indicator column present
+ *
+ * Nothing is converted to text, so the output is exact and cheap to load.
+ */
+class BinarySink : public ResultSink {
+  std::ostream &out;          ///< Destination
+  std::string buffer;         ///< Bytes written since the last commit
+  size_t symbols_written = 0; ///< Symbol table entries already written
+
+  template <typename T> void append(const T &value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> void append(std::span<const T> values) {
+    buffer.append(reinterpret_cast<const char *>(values.data()),
+                  values.size_bytes());
+  }
+
+public:
+  explicit BinarySink(std::ostream &destination) : out(destination) {}
+
+  void begin(const ResultColumns &columns) override {
+    out.write(BINARY_RESULT_MAGIC, sizeof(BINARY_RESULT_MAGIC));
+    write_binary(out, static_cast<uint8_t>(columns.sma | columns.ema << 1 |
+                                           columns.volatility << 2 |
+                                           columns.vwap << 3 |
+                                           columns.zscore << 4));
+  }
+
+  void write(const ResultBatch &batch) override {
+    append(static_cast<uint32_t>(batch.symbols.size() - symbols_written));
+    for (; symbols_written < batch.symbols.size(); ++symbols_written) {
+      std::string_view symbol = batch.symbols[symbols_written];
+      append(static_cast<uint32_t>(symbol.size()));
+      buffer += symbol;
+    }
+
+    append(static_cast<uint32_t>(batch.size));
+    for (std::string_view timestamp : batch.timestamps) {
+      int64_t ts_ns;
+      if (!parse_timestamp_ns(timestamp, ts_ns)) {
+        ts_ns = std::numeric_limits<int64_t>::min();
+      }
+      append(ts_ns);
+    }
+    append(batch.symbol_ids);
+    append(batch.prices);
+    append(batch.volumes);
+    for (std::span<const double> column :
+         {batch.sma, batch.ema, batch.volatility, batch.vwap, batch.zscore}) {
+      append(column);
+    }
+  }
+
+  size_t commit(bool flush) override {
+    const size_t bytes = buffer.size();
+    out.write(buffer.data(), static_cast<std::streamsize>(bytes));
+    if (flush) {
+      out.flush();
+    }
+    buffer.clear();
+    return bytes;
+  }
+};
+
+/**
+ * @class NullSink
+ * @brief Discards every row (--output=null), to measure compute throughput
+ */
+class NullSink : public ResultSink {
+public:
+  void write(const ResultBatch &) override {}
+};
+
+/**
+ * @class BinaryResultReader
+ * @brief Reads a stream written by BinarySink back into columns
+ */
+class BinaryResultReader {
+  std::istream &in;
+
+  template <typename T> bool read_column(std::vector<T> &column, size_t n) {
+    column.resize(n);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(column.data()),
+                                     static_cast<std::streamsize>(
+                                         n * sizeof(T))));
+  }
+
+public:
+  ResultColumns columns;            ///< Indicator columns present
+  std::vector<std::string> symbols; ///< Symbol names by id, so far
+  std::vector<int64_t> ts_ns;       ///< Timestamps of the last batch
+  std::vector<uint32_t> symbol_ids; ///< Symbol ids of the last batch
+  std::vector<double> prices;       ///< Prices of the last batch
+  std::vector<int64_t> volumes;     ///< Volumes of the last batch
+  std::vector<double> sma, ema, volatility, vwap, zscore; ///< Indicators
+                                                          ///< (if present)
+
+  /**
+   * @brief Reads the stream header
+   * @throws std::runtime_error if the stream is not a binary result stream
+   */
+  explicit BinaryResultReader(std::istream &input) : in(input) {
+    char magic[sizeof(BINARY_RESULT_MAGIC)];
+    uint8_t mask;
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, BINARY_RESULT_MAGIC, sizeof(magic)) != 0 ||
+        !read_binary(in, mask)) {
+      throw std::runtime_error("Not a binary result stream");
+    }
+    columns = {(mask & 1) != 0, (mask & 2) != 0, (mask & 4) != 0,
+               (mask & 8) != 0, (mask & 16) != 0};
+  }
+
+  /**
+   * @brief Reads the next batch into the column vectors
+   * @return false at the end of the stream
+   * @throws std::runtime_error if the stream ends inside a batch
+   */
+  bool next() {
+    uint32_t new_symbols;
+    if (!read_binary(in, new_symbols)) {
+      return false;
+    }
+    uint32_t n = 0;
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < new_symbols; ++i) {
+      ok = read_binary_string(in, symbols.emplace_back());
+    }
+    ok = ok && read_binary(in, n) && read_column(ts_ns, n) &&
+         read_column(symbol_ids, n) && read_column(prices, n) &&
+         read_column(volumes, n);
+    const bool present[] = {columns.sma, columns.ema, columns.volatility,
+                            columns.vwap, columns.zscore};
+    std::vector<double> *indicators[] = {&sma, &ema, &volatility, &vwap,
+                                         &zscore};
+    for (size_t k = 0; k < 5; ++k) {
+      ok = ok && read_column(*indicators[k], present[k] ? n : 0);
+    }
+    if (!ok) {
+      throw std::runtime_error("Truncated binary result stream");
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Creates the sink selected by --output
+ * @param format "csv", "binary" or "null"
+ * @param out Destination of the csv and binary sinks
+ * @throws std::invalid_argument for any other format
+ */
+inline std::unique_ptr<ResultSink> make_result_sink(const std::string &format,
+                                                    std::ostream &out) {
+  if (format == "csv") {
+    return std::make_unique<CsvSink>(out);
+  }
+  if (format == "binary") {
+    return std::make_unique<BinarySink>(out);
+  }
+  if (format == "null") {
+    return std::make_unique<NullSink>();
+  }
+  throw std::invalid_argument("--output supports 'csv', 'binary' or 'null'");
+}
+
+#endif
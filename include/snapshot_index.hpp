@@ -0,0 +1,399 @@
+#ifndef SNAPSHOT_INDEX_HPP
+#define SNAPSHOT_INDEX_HPP
+
+#include "binary_io.hpp"
+#include "csv.hpp"
+#include "indicators.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Magic bytes at the start of every snapshot index file
+ */
+inline constexpr char SNAPSHOT_INDEX_MAGIC[8] = {'P', 'A', 'I', 'D',
+                                                 'X', '0', '0', '3'};
+
+/**
+ * @brief Input bytes after which a symbol's next row is snapshotted anyway
+ *
+ * A query replays every line from its snapshot's offset, whatever the
+ * symbol, so a gap of N rows of one symbol is about N times the number of
+ * symbols in lines. Bounding the gap in bytes as well keeps a query to a
+ * few milliseconds of replay however many symbols the file interleaves.
+ */
+inline constexpr uint64_t SNAPSHOT_MAX_GAP_BYTES = uint64_t{4} << 20;
+
+/**
+ * @brief Leading input bytes hashed into an index's InputIdentity
+ */
+inline constexpr uint64_t INPUT_IDENTITY_BYTES = uint64_t{64} << 10;
+
+/**
+ * @struct InputIdentity
+ * @brief Size and leading bytes of the input an index was built from
+ *
+ * An index only describes the file it was built from: its offsets point
+ * into that file. The size runs to the end of the last non-empty line,
+ * with its newline, so trailing blank lines and a missing final newline do
+ * not count; the hash is 64-bit FNV-1a of the first INPUT_IDENTITY_BYTES
+ * of those bytes. Together they catch a different, edited, truncated or
+ * appended-to file without reading all of it.
+ */
+struct InputIdentity {
+  uint64_t size = 0;                      ///< Bytes of input seen
+  uint64_t hash = 0xcbf29ce484222325ull;  ///< FNV-1a of the leading bytes
+
+  /**
+   * @brief Appends input bytes
+   */
+  void add(std::string_view bytes) {
+    const uint64_t hashed =
+        size < INPUT_IDENTITY_BYTES
+            ? std::min<uint64_t>(bytes.size(), INPUT_IDENTITY_BYTES - size)
+            : 0;
+    for (uint64_t i = 0; i < hashed; ++i) {
+      hash ^= static_cast<unsigned char>(bytes[i]);
+      hash *= 0x100000001b3ull;
+    }
+    size += bytes.size();
+  }
+
+  /**
+   * @brief Appends a non-empty line and the blank lines before it
+   * @param line The line, without its newline
+   * @param end_offset Byte offset just past the line's newline
+   */
+  void add_line(std::string_view line, uint64_t end_offset) {
+    const uint64_t start = end_offset - line.size() - 1;
+    while (size < start && size < INPUT_IDENTITY_BYTES) {
+      add("\n");
+    }
+    size = std::max(size, start);
+    add(line);
+    add("\n");
+  }
+
+  bool operator==(const InputIdentity &) const = default;
+};
+
+/**
+ * @brief Computes the identity of an input file as the index writer sees it
+ * @param file The input, opened; its position is left unspecified
+ * @return The identity, or a default one if the file cannot be read
+ */
+inline InputIdentity input_identity(std::istream &file) {
+  InputIdentity identity;
+  if (!file.seekg(0, std::ios::end)) {
+    return identity;
+  }
+  // Trailing newlines are not part of the identity
+  uint64_t end = static_cast<uint64_t>(file.tellg());
+  char c = '\n';
+  while (end > 0 && c == '\n') {
+    file.seekg(static_cast<std::streamoff>(end - 1));
+    if (!file.get(c)) {
+      return InputIdentity();
+    }
+    end -= c == '\n';
+  }
+  if (end == 0) {
+    return identity;
+  }
+  std::string head(std::min(end, INPUT_IDENTITY_BYTES), '\0');
+  file.seekg(0);
+  if (!file.read(head.data(), static_cast<std::streamsize>(head.size()))) {
+    return InputIdentity();
+  }
+  identity.add(head);
+  identity.size = end;
+  identity.add("\n");
+  return identity;
+}
+
+/**
+ * @struct SnapshotEntry
+ * @brief One per-symbol snapshot: the row it was taken after and where the
+ * input continues
+ */
+struct SnapshotEntry {
+  std::string symbol;  ///< Symbol the snapshot belongs to
+  int64_t ts_ns = 0;   ///< Parsed timestamp of the snapshot row
+  uint64_t offset = 0; ///< Byte offset of the line after the snapshot row
+  ParsedRow row;       ///< The snapshot row itself (for as-of output)
+  std::string state;   ///< Serialized Series state after the row
+};
+
+/**
+ * @class SnapshotIndexWriter
+ * @brief Writes periodic per-symbol Series snapshots during a normal run
+ *
+ * Layout: magic, the indicator parameters the snapshots were taken with
+ * (sma window, ema span, vol window as int32), then a sequence of entries:
+ * symbol, timestamp (int64 ns), file offset (uint64), the snapshot row's
+ * timestamp string, price and volume, and the length-prefixed Series state.
+ * Entries appear in input order, so per symbol they are sorted by offset.
+ *
+ * finish() appends a directory so that a lookup reads only its own symbol's
+ * entry: for every symbol, the (timestamp, index position) pairs of its
+ * entries; then a table of symbol, pair count and position of its pairs;
+ * and last the InputIdentity of the input (size and hash, uint64 each) and
+ * the table's position (uint64).
+ *
+ * A snapshot is due after every_rows rows (or every_ns of time) of a symbol,
+ * or at its first row SNAPSHOT_MAX_GAP_BYTES or more past its last one.
+ */
+class SnapshotIndexWriter {
+  /**
+   * @struct Progress
+   * @brief Rows and time elapsed since a symbol's last snapshot
+   */
+  struct Progress {
+    uint64_t rows = 0; ///< Rows since the last snapshot
+    int64_t last_ts_ns =
+        std::numeric_limits<int64_t>::min(); ///< Time of the last snapshot
+                                             ///< (or of the first row)
+    uint64_t last_offset = 0; ///< Input offset of the last snapshot
+    std::vector<std::pair<int64_t, uint64_t>>
+        entries; ///< Time and index position of every snapshot
+  };
+
+  std::ofstream out;          ///< Index file
+  uint64_t position = 0;      ///< Bytes written to the index so far
+  uint64_t every_rows = 0;    ///< Row interval (or 0 for time-based)
+  int64_t every_ns = 0;       ///< Time interval (used when every_rows == 0)
+  std::ostringstream scratch; ///< Reused buffer for serializing a Series
+  std::ostringstream entry;   ///< Reused buffer for one entry
+  std::unordered_map<std::string, Progress> progress; ///< Per-symbol state
+  InputIdentity input; ///< Identity of the input read so far
+
+public:
+  /**
+   * @brief Creates the index file and writes its header
+   * @param path Index file path
+   * @param config Configuration (indicator parameters and snapshot interval)
+   * @return false if the file cannot be created
+   */
+  bool open(const std::string &path, const CLIConfig &config) {
+    out.open(path, std::ios::binary);
+    if (!out.is_open()) {
+      return false;
+    }
+    every_rows = config.index_every_rows;
+    every_ns = config.index_every_ns;
+
+    out.write(SNAPSHOT_INDEX_MAGIC, sizeof(SNAPSHOT_INDEX_MAGIC));
+    write_binary(out, static_cast<int32_t>(config.sma_window));
+    write_binary(out, static_cast<int32_t>(config.ema_span));
+    write_binary(out, static_cast<int32_t>(config.vol_window));
+    position = sizeof(SNAPSHOT_INDEX_MAGIC) + 3 * sizeof(int32_t);
+    return true;
+  }
+
+  /**
+   * @brief Records a line of input towards the input's identity
+   * @param line The line, without its newline (non-empty)
+   * @param end_offset Byte offset just past the line
+   */
+  void consume(std::string_view line, uint64_t end_offset) {
+    input.add_line(line, end_offset);
+  }
+
+  /**
+   * @brief Considers taking a snapshot after a row has been applied
+   * @param row The row just applied to series
+   * @param series The symbol's Series after the update
+   * @param next_offset Byte offset of the line following row
+   */
+  void observe(const ParsedRow &row, const Series &series,
+               uint64_t next_offset) {
+    int64_t ts_ns;
+    if (!parse_timestamp_ns(row.timestamp, ts_ns)) {
+      return; // Snapshots need a timestamp to be found by as-of queries
+    }
+
+    Progress &p = progress[row.symbol];
+    p.rows++;
+    if (p.last_ts_ns == std::numeric_limits<int64_t>::min()) {
+      p.last_ts_ns = ts_ns; // Time-based intervals start at the first row
+    }
+    bool due = every_rows != 0 ? p.rows >= every_rows
+                               : ts_ns - p.last_ts_ns >= every_ns;
+    if (!due && next_offset - p.last_offset < SNAPSHOT_MAX_GAP_BYTES) {
+      return;
+    }
+    p.rows = 0;
+    p.last_ts_ns = ts_ns;
+    p.last_offset = next_offset;
+    p.entries.emplace_back(ts_ns, position);
+
+    scratch.str(std::string());
+    series.save(scratch);
+
+    entry.str(std::string());
+    write_binary_string(entry, row.symbol);
+    write_binary(entry, ts_ns);
+    write_binary(entry, next_offset);
+    write_binary_string(entry, row.timestamp);
+    write_binary(entry, row.price);
+    write_binary(entry, row.volume);
+    write_binary_string(entry, scratch.str());
+    const std::string bytes = entry.str();
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    position += bytes.size();
+  }
+
+  /**
+   * @brief Appends the per-symbol directory and closes the file
+   *
+   * Call once, after the last row; does nothing if no index is open.
+   */
+  void finish() {
+    if (!out.is_open()) {
+      return;
+    }
+    std::vector<std::pair<const std::string *, uint64_t>> lists;
+    for (const auto &[symbol, p] : progress) {
+      lists.emplace_back(&symbol, position);
+      for (const auto &[ts_ns, at] : p.entries) {
+        write_binary(out, ts_ns);
+        write_binary(out, at);
+      }
+      position += p.entries.size() * (sizeof(int64_t) + sizeof(uint64_t));
+    }
+    const uint64_t table = position;
+    write_binary(out, static_cast<uint64_t>(lists.size()));
+    for (const auto &[symbol, at] : lists) {
+      write_binary_string(out, *symbol);
+      write_binary(out,
+                   static_cast<uint64_t>(progress[*symbol].entries.size()));
+      write_binary(out, at);
+    }
+    write_binary(out, input.size);
+    write_binary(out, input.hash);
+    write_binary(out, table);
+    out.close();
+  }
+};
+
+/**
+ * @brief Finds the latest snapshot of a symbol taken at or before a time
+ * @param path Index file written by SnapshotIndexWriter
+ * @param config Configuration whose indicator parameters must match the index
+ * @param input Identity of the input the query replays (input_identity())
+ * @param symbol Symbol to look up
+ * @param ts_ns Query time
+ * @param found Receives the snapshot if one exists
+ * @return true if a snapshot was found, false if none precedes ts_ns
+ * @throws std::runtime_error if the file is missing, corrupt, was built
+ * with different indicator parameters or from a different input
+ *
+ * Reads the directory at the end of the index: scans the symbol table for
+ * the symbol, reads that symbol's snapshot times, binary-searches them and
+ * reads only the entry found. A lookup thus grows with the number of
+ * symbols and of the symbol's snapshots, but never reads another entry's
+ * state.
+ */
+inline bool find_snapshot(const std::string &path, const CLIConfig &config,
+                          const InputIdentity &input,
+                          const std::string &symbol, int64_t ts_ns,
+                          SnapshotEntry &found) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("Cannot open index '" + path + "'");
+  }
+
+  char magic[sizeof(SNAPSHOT_INDEX_MAGIC)];
+  int32_t sma_window, ema_span, vol_window;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, SNAPSHOT_INDEX_MAGIC, sizeof(magic)) != 0 ||
+      !read_binary(in, sma_window) || !read_binary(in, ema_span) ||
+      !read_binary(in, vol_window)) {
+    throw std::runtime_error("'" + path + "' is not a snapshot index");
+  }
+  if (sma_window != config.sma_window || ema_span != config.ema_span ||
+      vol_window != config.vol_window) {
+    throw std::runtime_error(
+        "Index was built with --sma=" + std::to_string(sma_window) +
+        " --ema=" + std::to_string(ema_span) +
+        " --vol=" + std::to_string(vol_window) + "; query must match");
+  }
+
+  auto truncated = [&] {
+    return std::runtime_error("Truncated index '" + path + "'");
+  };
+  InputIdentity built;
+  uint64_t table;
+  if (!in.seekg(-static_cast<std::streamoff>(3 * sizeof(uint64_t)),
+                std::ios::end) ||
+      !read_binary(in, built.size) || !read_binary(in, built.hash) ||
+      !read_binary(in, table) ||
+      !in.seekg(static_cast<std::streamoff>(table))) {
+    throw truncated();
+  }
+  if (!(built == input)) {
+    throw std::runtime_error("Index '" + path + "' was built from a "
+                             "different input (" +
+                             std::to_string(built.size) + " bytes)");
+  }
+  uint64_t symbols;
+  if (!read_binary(in, symbols)) {
+    throw truncated();
+  }
+  uint64_t count = 0;
+  uint64_t list = 0;
+  std::string name;
+  for (uint64_t i = 0; i < symbols; ++i) {
+    uint64_t entries, at;
+    if (!read_binary_string(in, name) || !read_binary(in, entries) ||
+        !read_binary(in, at)) {
+      throw truncated();
+    }
+    if (name == symbol) {
+      count = entries;
+      list = at;
+      break;
+    }
+  }
+
+  // A symbol's snapshots are in input (time) order
+  std::vector<std::pair<int64_t, uint64_t>> times(count);
+  in.seekg(static_cast<std::streamoff>(list));
+  for (auto &[entry_ns, at] : times) {
+    if (!read_binary(in, entry_ns) || !read_binary(in, at)) {
+      throw truncated();
+    }
+  }
+  const auto after = std::upper_bound(
+      times.begin(), times.end(), ts_ns,
+      [](int64_t query, const auto &time) { return query < time.first; });
+  if (after == times.begin()) {
+    return false;
+  }
+
+  SnapshotEntry entry;
+  in.seekg(static_cast<std::streamoff>((after - 1)->second));
+  if (!read_binary_string(in, entry.symbol) || !read_binary(in, entry.ts_ns) ||
+      !read_binary(in, entry.offset) ||
+      !read_binary_string(in, entry.row.timestamp) ||
+      !read_binary(in, entry.row.price) ||
+      !read_binary(in, entry.row.volume) ||
+      !read_binary_string(in, entry.state) || entry.symbol != symbol) {
+    throw truncated();
+  }
+  entry.row.symbol = entry.symbol;
+  entry.row.is_valid = true;
+  found = std::move(entry);
+  return true;
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef SUMMARY_HPP
+#define SUMMARY_HPP
+
+#include "indicators.hpp"
+#include "sink.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct SymbolSummary
+ * @brief One symbol's aggregates over the whole run (--summary)
+ */
+struct SymbolSummary {
+  const Series *series = nullptr; ///< The symbol's indicators
+  std::string_view name;          ///< The symbol's name
+  uint64_t count = 0;             ///< Trades
+  std::string first_timestamp;    ///< Timestamp of the first trade
+  std::string last_timestamp;     ///< Timestamp of the last trade
+  double min_price = std::numeric_limits<double>::infinity();
+  double max_price = -std::numeric_limits<double>::infinity();
+  RunningSum price_sum;           ///< Sum of prices (for the mean)
+  int64_t volume = 0;             ///< Total volume
+  double peak = 0.0;              ///< Highest price so far
+  double max_drawdown = 0.0;      ///< Largest fall from a peak, as a fraction
+};
+
+/**
+ * @class SummaryReport
+ * @brief Per-symbol aggregates printed once at the end of the input
+ *
+ * Replaces per-row output: a trade only updates a few running aggregates of
+ * its symbol, in a dense array indexed by symbol id, so the run costs
+ * little more than the indicator updates themselves. At the end, one CSV
+ * row per symbol (in order of first appearance):
+ *   symbol,count,first_timestamp,last_timestamp,min_price,max_price,
+ *   mean_price,total_volume[,sma,ema,volatility,vwap],max_drawdown
+ * where the indicator columns are the final values, for the indicators
+ * enabled, and max_drawdown is the largest fall of the price from an
+ * earlier high, as a fraction of that high.
+ */
+class SummaryReport {
+  ResultColumns columns;               ///< Indicator columns printed
+  std::ostream &out;                   ///< Destination
+  std::vector<SymbolSummary> symbols;  ///< By symbol id
+
+public:
+  /**
+   * @brief Creates an empty report
+   * @param indicator_columns Final indicator values to print
+   * @param destination Where the report goes
+   */
+  SummaryReport(const ResultColumns &indicator_columns,
+                std::ostream &destination)
+      : columns(indicator_columns), out(destination) {}
+
+  /**
+   * @brief Adds a trade to its symbol's aggregates
+   * @param id The symbol's id
+   * @param name The symbol's name (must stay valid)
+   * @param series The symbol's indicators (must stay valid)
+   * @param timestamp The trade's timestamp
+   * @param price The trade's price
+   * @param volume The trade's volume
+   */
+  void observe(uint32_t id, std::string_view name, const Series &series,
+               std::string_view timestamp, double price, int64_t volume) {
+    if (id >= symbols.size()) {
+      symbols.resize(id + 1);
+    }
+    SymbolSummary &symbol = symbols[id];
+    if (symbol.count++ == 0) {
+      symbol.series = &series;
+      symbol.name = name;
+      symbol.first_timestamp = timestamp;
+    }
+    symbol.last_timestamp = timestamp;
+    symbol.min_price = std::min(symbol.min_price, price);
+    symbol.max_price = std::max(symbol.max_price, price);
+    symbol.price_sum.add(price);
+    symbol.volume += volume;
+    symbol.peak = std::max(symbol.peak, price);
+    if (symbol.peak > 0) {
+      symbol.max_drawdown =
+          std::max(symbol.max_drawdown, (symbol.peak - price) / symbol.peak);
+    }
+  }
+
+  /**
+   * @brief Prints the header and one row per symbol that traded
+   */
+  void report() {
+    std::string text = "symbol,count,first_timestamp,last_timestamp,"
+                       "min_price,max_price,mean_price,total_volume";
+    text += columns.sma ? ",sma" : "";
+    text += columns.ema ? ",ema" : "";
+    text += columns.volatility ? ",volatility" : "";
+    text += columns.vwap ? ",vwap" : "";
+    text += ",max_drawdown\n";
+    auto field = [&](double value) {
+      text += ',';
+      text += std::to_string(value);
+    };
+    for (const SymbolSummary &symbol : symbols) {
+      if (symbol.count == 0) {
+        continue; // An id given to a symbol that never traded
+      }
+      text += symbol.name;
+      text += ',' + std::to_string(symbol.count);
+      text += ',';
+      text += symbol.first_timestamp;
+      text += ',';
+      text += symbol.last_timestamp;
+      field(symbol.min_price);
+      field(symbol.max_price);
+      field(symbol.price_sum.value() / static_cast<double>(symbol.count));
+      text += ',' + std::to_string(symbol.volume);
+      if (columns.sma) {
+        field(symbol.series->get_indicator(IndicatorType::SMA));
+      }
+      if (columns.ema) {
+        field(symbol.series->get_indicator(IndicatorType::EMA));
+      }
+      if (columns.volatility) {
+        field(symbol.series->get_indicator(IndicatorType::VOLATILITY));
+      }
+      if (columns.vwap) {
+        field(symbol.series->get_indicator(IndicatorType::VWAP));
+      }
+      field(symbol.max_drawdown);
+      text += '\n';
+    }
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    out.flush();
+  }
+};
+
+#endif
@@ -0,0 +1,478 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "analyzer.hpp"
+#include "binary_io.hpp"
+#include "csv.hpp"
+#include "indicators.hpp"
+#include "workers.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Magic bytes at the start of every sweep matrix stream
+ */
+inline constexpr char SWEEP_MATRIX_MAGIC[8] = {'P', 'A', 'S', 'W',
+                                               'E', 'E', 'P', '1'};
+
+/**
+ * @struct SweepSymbol
+ * @brief One symbol's state for every swept parameter at once
+ *
+ * For SMA sweeps, the symbol keeps compensated prefix sums of its prices:
+ * the window sum of any width w ending at row j is prefix[j] - prefix[j-w],
+ * so each row costs one subtraction per window whatever the widths. Only the
+ * last (widest window + 1) sums are needed; older ones are dropped, and the
+ * rest rebased to zero, once twice that many have accumulated, which keeps
+ * the sums small and the differences accurate. For EMA sweeps it keeps one
+ * EMA per span.
+ *
+ * Like Series, the first price (and the first after a zero price) only
+ * seeds the symbol: it is output with the values unchanged.
+ */
+struct SweepSymbol {
+  uint32_t id = 0;               ///< Index into the symbol table
+  uint64_t count = 0;            ///< Prices the indicators were updated with
+  double last_price = 0.0;       ///< Previous price (0 = next one seeds)
+  std::vector<double> prefix{0.0};   ///< Prefix sums (rounded part)
+  std::vector<double> residual{0.0}; ///< Rounding error of each prefix sum
+  std::vector<double> ema;       ///< EMA per span (EMA sweeps)
+
+  /**
+   * @brief Appends a price's prefix sum
+   */
+  void push(double price) {
+    RunningSum sum{prefix.back(), residual.back()};
+    sum.add(price);
+    prefix.push_back(sum.sum);
+    residual.push_back(sum.compensation);
+  }
+
+  /**
+   * @brief Drops prefix sums no window can reach once 2 * keep have built up
+   * @param keep Sums to keep (widest window + 1)
+   */
+  void trim(size_t keep) {
+    if (prefix.size() < 2 * keep) {
+      return;
+    }
+    const size_t first = prefix.size() - keep;
+    const RunningSum base{prefix[first], residual[first]};
+    for (size_t i = 0; i < keep; ++i) {
+      RunningSum sum{prefix[first + i], residual[first + i]};
+      sum.add(-base.sum);
+      prefix[i] = sum.sum;
+      residual[i] = sum.compensation - base.compensation;
+    }
+    prefix.resize(keep);
+    residual.resize(keep);
+  }
+};
+
+/**
+ * @class IndicatorFamily
+ * @brief One indicator computed for many windows or spans at once
+ *
+ * Holds every symbol's SweepSymbol state. Each batch, collect() assigns the
+ * batch's rows to their symbols; compute() then fills the batch's matrix of
+ * values (one row per collected row, one column per parameter) and can run
+ * on disjoint blocks of parameters concurrently; end_batch() releases
+ * prefix sums no window needs any more. Used by --sweep, which writes the
+ * matrix, and by --backtest, which evaluates rules on it.
+ */
+class IndicatorFamily {
+  std::vector<int32_t> parameter_list; ///< Windows or spans, by column
+  std::vector<double> alphas;          ///< EMA smoothing factor per span
+  bool sma;                            ///< SMA family (otherwise EMA)
+  size_t keep;                         ///< Prefix sums kept per symbol
+
+  std::unordered_map<std::string, SweepSymbol> symbols;
+  std::vector<std::string_view> names; ///< Keys of symbols by id
+
+  /**
+   * @brief Fills matrix columns [begin, end) of the batch's SMA rows
+   */
+  void sma_block(size_t begin, size_t end) {
+    const size_t width = parameter_list.size();
+    for (size_t r = 0; r < rows.size(); ++r) {
+      const SweepSymbol &symbol = *row_symbols[r];
+      const double *prefix = symbol.prefix.data() + row_prefix[r];
+      const double *residual = symbol.residual.data() + row_prefix[r];
+      const uint64_t count = row_count[r];
+      double *out = matrix.data() + r * width;
+      if (count == 0) {
+        std::fill(out + begin, out + end, 0.0);
+        continue;
+      }
+      for (size_t k = begin; k < end; ++k) {
+        const uint64_t n = std::min<uint64_t>(
+            static_cast<uint64_t>(parameter_list[k]), count);
+        const double sum = (prefix[0] - *(prefix - n)) +
+                           (residual[0] - *(residual - n));
+        out[k] = sum / static_cast<double>(n);
+      }
+    }
+  }
+
+  /**
+   * @brief Advances spans [begin, end) of the EMAs over the batch's rows
+   *
+   * Same recurrence and seeding as EMAIndicator, so values are identical to
+   * a --ema run with the same span.
+   */
+  void ema_block(size_t begin, size_t end) {
+    const size_t width = parameter_list.size();
+    for (size_t r = 0; r < rows.size(); ++r) {
+      const double price = rows[r]->price;
+      double *ema = row_symbols[r]->ema.data();
+      double *out = matrix.data() + r * width;
+      if (!row_updated[r]) {
+        std::copy(ema + begin, ema + end, out + begin);
+        continue;
+      }
+      if (row_count[r] == 1) {
+        for (size_t k = begin; k < end; ++k) {
+          ema[k] = out[k] = price;
+        }
+        continue;
+      }
+      for (size_t k = begin; k < end; ++k) {
+        const double alpha = alphas[k];
+        ema[k] = out[k] = alpha * price + (1 - alpha) * ema[k];
+      }
+    }
+  }
+
+public:
+  std::vector<const ParsedRow *> rows;  ///< The batch's collected rows
+  std::vector<SweepSymbol *> row_symbols;
+  std::vector<size_t> row_prefix;       ///< Index of each row's prefix sum
+  std::vector<uint64_t> row_count;      ///< Symbol's updates up to the row
+  std::vector<uint8_t> row_updated;     ///< Row updated (did not seed)
+  std::vector<double> row_returns; ///< Return since the symbol's previous
+                                   ///< price (0 for seeding rows)
+  std::vector<double> matrix;      ///< Row-major values of the batch
+
+  /**
+   * @brief Creates an empty family
+   * @param indicator "sma" or "ema"
+   * @param parameters Windows or spans, in column order
+   */
+  IndicatorFamily(const std::string &indicator,
+                  std::vector<int32_t> parameters)
+      : parameter_list(std::move(parameters)), sma(indicator == "sma"),
+        keep(static_cast<size_t>(*std::max_element(parameter_list.begin(),
+                                                   parameter_list.end())) +
+             1) {
+    for (int32_t span : parameter_list) {
+      alphas.push_back(span_to_alpha(span));
+    }
+  }
+
+  /**
+   * @brief Returns the windows or spans, in column order
+   */
+  const std::vector<int32_t> &parameters() const { return parameter_list; }
+
+  /**
+   * @brief Returns true for an SMA family, false for EMA
+   */
+  bool is_sma() const { return sma; }
+
+  /**
+   * @brief Returns every symbol's name, indexed by SweepSymbol::id
+   */
+  const std::vector<std::string_view> &symbol_names() const { return names; }
+
+  /**
+   * @brief Assigns a parsed batch's rows to symbols and appends their prices
+   * @param batch The parsed batch
+   * @param filter_symbol Only collect this symbol's rows (empty = all)
+   */
+  void collect(const InputBatch &batch, const std::string &filter_symbol) {
+    rows.clear();
+    row_symbols.clear();
+    row_prefix.clear();
+    row_count.clear();
+    row_updated.clear();
+    row_returns.clear();
+    for (size_t i = 0; i < batch.size; ++i) {
+      const ParsedRow &row = batch.rows[i];
+      if (!row.is_valid || row.action != RowAction::TRADE ||
+          (!filter_symbol.empty() && row.symbol != filter_symbol)) {
+        continue;
+      }
+      auto found = symbols.find(row.symbol);
+      if (found == symbols.end()) {
+        found = symbols.emplace(row.symbol, SweepSymbol{}).first;
+        found->second.id = static_cast<uint32_t>(names.size());
+        found->second.ema.resize(sma ? 0 : parameter_list.size());
+        names.push_back(found->first);
+      }
+      SweepSymbol &symbol = found->second;
+      const bool update = symbol.last_price != 0;
+      row_returns.push_back(update ? row.price / symbol.last_price - 1.0
+                                   : 0.0);
+      symbol.last_price = row.price;
+      if (update) {
+        symbol.count++;
+        if (sma) {
+          symbol.push(row.price);
+        }
+      }
+      rows.push_back(&row);
+      row_symbols.push_back(&symbol);
+      row_prefix.push_back(symbol.prefix.size() - 1);
+      row_count.push_back(symbol.count);
+      row_updated.push_back(update);
+    }
+    matrix.resize(rows.size() * parameter_list.size());
+  }
+
+  /**
+   * @brief Fills matrix columns [begin, end) for the collected rows
+   */
+  void compute(size_t begin, size_t end) {
+    sma ? sma_block(begin, end) : ema_block(begin, end);
+  }
+
+  /**
+   * @brief Drops prefix sums the next batch cannot need
+   */
+  void end_batch() {
+    if (sma) {
+      for (SweepSymbol *symbol : row_symbols) {
+        symbol->trim(keep);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Returns the worker count for --threads (0 = one per core), capped
+ * at the number of work items per batch
+ */
+inline unsigned worker_threads(const CLIConfig &config, size_t items) {
+  const unsigned wanted =
+      config.threads != 0 ? config.threads
+                          : std::max(1u, std::thread::hardware_concurrency());
+  return static_cast<unsigned>(std::min<size_t>(wanted, items));
+}
+
+/**
+ * @class SweepRunner
+ * @brief Computes a family of SMAs or EMAs in one pass (--sweep)
+ *
+ * Each batch is read and parsed once; its rows then get one value per
+ * parameter, computed on a WorkerPool that splits the parameters into
+ * blocks (every thread fills its own columns of the batch's matrix).
+ *
+ * Output layout (native-endian): magic, uint8 indicator (0 SMA, 1 EMA),
+ * uint32 parameter count p, p int32 parameters, then per batch:
+ *   - uint32 count of symbols first seen in this batch, each a
+ *     length-prefixed string (their ids continue from the previous batch)
+ *   - uint32 row count n
+ *   - n int64 timestamps in ns since the epoch (INT64_MIN if unparsable),
+ *     n uint32 symbol ids, n double prices, n int64 volumes
+ *   - n * p doubles, row-major: row i's value for parameter k at i * p + k
+ */
+class SweepRunner {
+  CLIConfig config;
+  CLIConfig reader_config; ///< Defaults: the reader only parses
+  CSVAnalyzer reader;      ///< Reads and parses the batches
+  IndicatorFamily family;
+  WorkerPool workers;
+  InputBatch batch;
+  size_t symbols_written = 0; ///< Symbol table entries already written
+  std::string buffer;         ///< Bytes of the batch
+
+  template <typename T> void append(const T &value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  /**
+   * @brief Serializes the batch into buffer
+   */
+  void encode_batch() {
+    const auto &names = family.symbol_names();
+    append(static_cast<uint32_t>(names.size() - symbols_written));
+    for (; symbols_written < names.size(); ++symbols_written) {
+      std::string_view name = names[symbols_written];
+      append(static_cast<uint32_t>(name.size()));
+      buffer += name;
+    }
+    append(static_cast<uint32_t>(family.rows.size()));
+    for (const ParsedRow *row : family.rows) {
+      int64_t ts_ns;
+      if (!parse_timestamp_ns(row->timestamp, ts_ns)) {
+        ts_ns = std::numeric_limits<int64_t>::min();
+      }
+      append(ts_ns);
+    }
+    for (const SweepSymbol *symbol : family.row_symbols) {
+      append(symbol->id);
+    }
+    for (const ParsedRow *row : family.rows) {
+      append(row->price);
+    }
+    for (const ParsedRow *row : family.rows) {
+      append(static_cast<int64_t>(row->volume));
+    }
+    buffer.append(reinterpret_cast<const char *>(family.matrix.data()),
+                  family.matrix.size() * sizeof(double));
+  }
+
+public:
+  /**
+   * @brief Prepares a sweep
+   * @param sweep_config Configuration with --sweep set
+   */
+  explicit SweepRunner(const CLIConfig &sweep_config)
+      : config(sweep_config), reader(reader_config),
+        family(sweep_config.sweep_indicator,
+               sweep_config.sweep_range.values()),
+        workers(worker_threads(sweep_config, family.parameters().size())) {
+    batch.allocate();
+  }
+
+  /**
+   * @brief Sweeps a stream, writing the matrix to out
+   * @param input Stream positioned at the first data line
+   * @param out Destination, or nullptr to compute without writing
+   * (--output=null)
+   * @return true once the stream has been fully consumed
+   */
+  bool run(std::istream &input, std::ostream *out) {
+    const std::vector<int32_t> &parameters = family.parameters();
+    if (out) {
+      out->write(SWEEP_MATRIX_MAGIC, sizeof(SWEEP_MATRIX_MAGIC));
+      write_binary(*out, static_cast<uint8_t>(family.is_sma() ? 0 : 1));
+      write_binary(*out, static_cast<uint32_t>(parameters.size()));
+      out->write(reinterpret_cast<const char *>(parameters.data()),
+                 static_cast<std::streamsize>(parameters.size() *
+                                              sizeof(int32_t)));
+    }
+
+    const std::function<void(size_t, size_t)> block =
+        [this](size_t begin, size_t end) { family.compute(begin, end); };
+    bool more = true;
+    while (more) {
+      more = reader.read_batch(input, batch);
+      reader.parse_batch(batch);
+      family.collect(batch, config.filter_symbol);
+      workers.run(parameters.size(), block);
+      family.end_batch();
+
+      if (out) {
+        encode_batch();
+        out->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (batch.drained) {
+          out->flush();
+        }
+        buffer.clear();
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * @class SweepReader
+ * @brief Reads a stream written by --sweep back into columns
+ */
+class SweepReader {
+  std::istream &in;
+
+  template <typename T> bool read_column(std::vector<T> &column, size_t n) {
+    column.resize(n);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(column.data()),
+                                     static_cast<std::streamsize>(
+                                         n * sizeof(T))));
+  }
+
+public:
+  std::string indicator;            ///< "sma" or "ema"
+  std::vector<int32_t> parameters;  ///< Windows or spans, by column
+  std::vector<std::string> symbols; ///< Symbol names by id, so far
+  std::vector<int64_t> ts_ns;       ///< Timestamps of the last batch
+  std::vector<uint32_t> symbol_ids; ///< Symbol ids of the last batch
+  std::vector<double> prices;       ///< Prices of the last batch
+  std::vector<int64_t> volumes;     ///< Volumes of the last batch
+  std::vector<double> values; ///< Row-major matrix of the last batch
+
+  /**
+   * @brief Reads the stream header
+   * @throws std::runtime_error if the stream is not a sweep matrix
+   */
+  explicit SweepReader(std::istream &input) : in(input) {
+    char magic[sizeof(SWEEP_MATRIX_MAGIC)];
+    uint8_t kind;
+    uint32_t count;
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, SWEEP_MATRIX_MAGIC, sizeof(magic)) != 0 ||
+        !read_binary(in, kind) || kind > 1 || !read_binary(in, count) ||
+        !read_column(parameters, count)) {
+      throw std::runtime_error("Not a sweep matrix stream");
+    }
+    indicator = kind == 0 ? "sma" : "ema";
+  }
+
+  /**
+   * @brief Reads the next batch
+   * @return false at the end of the stream
+   * @throws std::runtime_error if the stream ends inside a batch
+   */
+  bool next() {
+    uint32_t new_symbols;
+    if (!read_binary(in, new_symbols)) {
+      return false;
+    }
+    uint32_t n = 0;
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < new_symbols; ++i) {
+      ok = read_binary_string(in, symbols.emplace_back());
+    }
+    ok = ok && read_binary(in, n) && read_column(ts_ns, n) &&
+         read_column(symbol_ids, n) && read_column(prices, n) &&
+         read_column(volumes, n) &&
+         read_column(values, size_t{n} * parameters.size());
+    if (!ok) {
+      throw std::runtime_error("Truncated sweep matrix stream");
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Runs --sweep over config.input_filename, writing to standard output
+ * @return false (after printing an error) if the input cannot be opened
+ */
+inline bool run_sweep(const CLIConfig &config) {
+  SweepRunner runner(config);
+  std::ostream *out = config.output_format == "null" ? nullptr : &std::cout;
+  if (config.input_filename == "-") {
+    return runner.run(std::cin, out);
+  }
+  std::ifstream input(config.input_filename);
+  if (!input.is_open()) {
+    std::cerr << "Error: Cannot open file '" << config.input_filename << "'\n";
+    return false;
+  }
+  return runner.run(input, out);
+}
+
+#endif
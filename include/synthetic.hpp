@@ -0,0 +1,343 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include "csv.hpp"
+#include "indicators.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct BasketLeg
+ * @brief A symbol's place in one basket (an entry of its fan-out list)
+ */
+struct BasketLeg {
+  uint32_t basket;      ///< Index of the basket
+  uint32_t constituent; ///< Index of the symbol among the basket's names
+};
+
+/**
+ * @class Basket
+ * @brief Weighted sum of its constituents' last prices (--basket)
+ *
+ * Each trade of a constituent replaces only that constituent's term, so an
+ * update costs O(1) whatever the basket's size. The sum is compensated
+ * (RunningSum), so the terms added and removed over a long run do not make
+ * it drift from a sum taken from scratch.
+ *
+ * The basket has no value until every constituent has traded.
+ */
+class Basket {
+  std::string basket_name;           ///< Name of the synthetic symbol
+  std::vector<std::string> names;    ///< Constituents
+  std::vector<double> weights;       ///< Weight, by constituent
+  std::vector<double> last;          ///< Last price, by constituent
+  std::vector<uint8_t> priced;       ///< 1 once a constituent has traded
+  size_t unpriced;                   ///< Constituents yet to trade
+  RunningSum total;                  ///< Sum of weight * last price
+
+public:
+  /**
+   * @brief Creates a basket
+   * @param name Name of the synthetic symbol
+   * @param constituents Symbols and weights, each symbol once
+   */
+  Basket(std::string name,
+         std::vector<std::pair<std::string, double>> constituents)
+      : basket_name(std::move(name)), last(constituents.size()),
+        priced(constituents.size()), unpriced(constituents.size()) {
+    for (auto &[symbol, weight] : constituents) {
+      names.push_back(std::move(symbol));
+      weights.push_back(weight);
+    }
+  }
+
+  /**
+   * @brief Returns the name of the synthetic symbol
+   */
+  const std::string &name() const { return basket_name; }
+
+  /**
+   * @brief Returns the constituents' symbols
+   */
+  const std::vector<std::string> &constituents() const { return names; }
+
+  /**
+   * @brief Replaces a constituent's last price
+   * @param constituent Index of the constituent
+   * @param price The constituent's trade price
+   * @return true if every constituent has a price, i.e. value() is valid
+   */
+  bool update(uint32_t constituent, double price) {
+    const double weight = weights[constituent];
+    if (priced[constituent]) {
+      total.add(-weight * last[constituent]);
+    } else {
+      priced[constituent] = 1;
+      unpriced--;
+    }
+    total.add(weight * price);
+    last[constituent] = price;
+    return unpriced == 0;
+  }
+
+  /**
+   * @brief Returns the basket's value
+   */
+  double value() const { return total.value(); }
+};
+
+/**
+ * @struct PairLeg
+ * @brief A symbol's place in one pair (an entry of its fan-out list)
+ */
+struct PairLeg {
+  uint32_t pair; ///< Index of the pair
+  uint32_t side; ///< 0 for the first leg, 1 for the second
+};
+
+/**
+ * @class PairSeries
+ * @brief Ratio or spread of two symbols' last prices, with a rolling
+ * z-score (--pair)
+ *
+ * Either leg's trade gives a new value once both legs have traded. The
+ * z-score compares that value with the mean and sample standard deviation
+ * of the last `window` values, which are kept in a ring so that both sums
+ * are moved by one value in and one value out: O(1) per update.
+ */
+class PairSeries {
+  PairSpec spec;                ///< Legs, kind and name
+  double last[2] = {0.0, 0.0};  ///< Last price of each leg
+  uint8_t priced = 0;           ///< Bit per leg that has traded
+  std::vector<double> ring;     ///< Last values, oldest at `head` once full
+  size_t head = 0;              ///< Next slot to overwrite
+  size_t count = 0;             ///< Values in the ring
+  RunningSum sum;               ///< Sum of the ring's values
+  RunningSum sum_sq;            ///< Sum of their squares
+  double current = 0.0;         ///< Latest value
+
+public:
+  /**
+   * @brief Creates a pair
+   * @param pair Legs and kind
+   * @param window Values in the z-score's window (at least 2)
+   */
+  PairSeries(PairSpec pair, size_t window)
+      : spec(std::move(pair)), ring(window) {}
+
+  /**
+   * @brief Returns the pair's legs, kind and name
+   */
+  const PairSpec &legs() const { return spec; }
+
+  /**
+   * @brief Replaces a leg's last price
+   * @param side 0 for the first leg, 1 for the second
+   * @param price The leg's trade price
+   * @return true if a new value was added: both legs have a price (and, for
+   * a ratio, the second is not 0)
+   */
+  bool update(uint32_t side, double price) {
+    last[side] = price;
+    priced |= static_cast<uint8_t>(1u << side);
+    if (priced != 3 || (!spec.spread && last[1] == 0.0)) {
+      return false;
+    }
+    current = spec.spread ? last[0] - spec.beta * last[1] : last[0] / last[1];
+    if (count == ring.size()) {
+      sum.add(-ring[head]);
+      sum_sq.add(-ring[head] * ring[head]);
+    } else {
+      count++;
+    }
+    ring[head] = current;
+    head = head + 1 == ring.size() ? 0 : head + 1;
+    sum.add(current);
+    sum_sq.add(current * current);
+    return true;
+  }
+
+  /**
+   * @brief Returns the latest value
+   */
+  double value() const { return current; }
+
+  /**
+   * @brief Returns the latest value's z-score in the window (0 until the
+   * window holds two distinct values)
+   */
+  double zscore() const {
+    if (count < 2) {
+      return 0.0;
+    }
+    const double n = static_cast<double>(count);
+    const double mean = sum.value() / n;
+    const double variance = (sum_sq.value() - sum.value() * mean) / (n - 1);
+    return variance > 0 ? (current - mean) / std::sqrt(variance) : 0.0;
+  }
+};
+
+/**
+ * @brief Reads a basket's weights file
+ * @param input Lines of "symbol,weight"; a first line whose weight is not a
+ * number is taken as a header, blank lines are skipped
+ * @param source Name used in error messages
+ * @return The constituents, in file order
+ * @throws std::runtime_error on a malformed line, a repeated symbol or an
+ * empty file, as "source:line: message"
+ */
+inline std::vector<std::pair<std::string, double>>
+parse_basket_weights(std::istream &input, const std::string &source) {
+  std::vector<std::pair<std::string, double>> constituents;
+  std::unordered_map<std::string, size_t> seen;
+  std::string line;
+  for (size_t number = 1; std::getline(input, line); ++number) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.find_first_not_of(" \t") == std::string::npos) {
+      continue;
+    }
+    auto fail = [&](const std::string &message) {
+      return std::runtime_error(source + ":" + std::to_string(number) +
+                                ": " + message);
+    };
+    const size_t comma = line.find(',');
+    if (comma == std::string::npos || comma == 0) {
+      throw fail("expected symbol,weight");
+    }
+    const std::string_view text = std::string_view(line).substr(comma + 1);
+    double weight;
+    const auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), weight);
+    if (ec != std::errc() || end != text.data() + text.size() ||
+        !std::isfinite(weight)) {
+      if (number == 1) {
+        continue; // Header
+      }
+      throw fail("expected a number as the weight");
+    }
+    std::string symbol = line.substr(0, comma);
+    if (!seen.emplace(symbol, number).second) {
+      throw fail("'" + symbol + "' is listed twice");
+    }
+    constituents.emplace_back(std::move(symbol), weight);
+  }
+  if (constituents.empty()) {
+    throw std::runtime_error(source + ": no constituents");
+  }
+  return constituents;
+}
+
+/**
+ * @brief Loads the baskets of a configuration
+ * @param specs --basket values, "name:weights.csv" each
+ * @return The baskets, in flag order
+ * @throws std::runtime_error if a weights file cannot be read or is
+ * malformed, or if a basket is named after a constituent or another basket
+ */
+inline std::vector<Basket>
+load_baskets(const std::vector<std::string> &specs) {
+  std::vector<Basket> baskets;
+  std::unordered_map<std::string, size_t> names;
+  for (const std::string &spec : specs) {
+    const size_t colon = spec.find(':');
+    const std::string name = spec.substr(0, colon);
+    const std::string path = spec.substr(colon + 1);
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      throw std::runtime_error("Cannot open file '" + path + "'");
+    }
+    baskets.emplace_back(name, parse_basket_weights(file, path));
+    if (!names.emplace(name, baskets.size()).second) {
+      throw std::runtime_error("Basket '" + name + "' is defined twice");
+    }
+  }
+  for (const Basket &basket : baskets) {
+    for (const std::string &symbol : basket.constituents()) {
+      if (names.count(symbol) != 0) {
+        throw std::runtime_error("Basket '" + symbol +
+                                 "' is named like a constituent");
+      }
+    }
+  }
+  return baskets;
+}
+
+/**
+ * @brief Builds every symbol's fan-out list: the baskets it belongs to
+ * @return Legs by symbol; symbols in no basket have no entry
+ */
+inline std::unordered_map<std::string, std::vector<BasketLeg>>
+basket_legs(const std::vector<Basket> &baskets) {
+  std::unordered_map<std::string, std::vector<BasketLeg>> legs;
+  for (size_t b = 0; b < baskets.size(); ++b) {
+    const std::vector<std::string> &symbols = baskets[b].constituents();
+    for (size_t c = 0; c < symbols.size(); ++c) {
+      legs[symbols[c]].push_back(
+          {static_cast<uint32_t>(b), static_cast<uint32_t>(c)});
+    }
+  }
+  return legs;
+}
+
+/**
+ * @brief Creates the pairs of a configuration
+ * @param specs --pair values
+ * @param window Values in each z-score's window
+ * @param baskets The configuration's baskets
+ * @return The pairs, in flag order
+ * @throws std::runtime_error if two pairs or a pair and a basket have the
+ * same name, or a basket holds a pair (pairs may hold baskets)
+ */
+inline std::vector<PairSeries> load_pairs(const std::vector<PairSpec> &specs,
+                                          size_t window,
+                                          const std::vector<Basket> &baskets) {
+  std::unordered_map<std::string, size_t> names;
+  for (const Basket &basket : baskets) {
+    names.emplace(basket.name(), 0);
+  }
+  std::vector<PairSeries> pairs;
+  for (const PairSpec &spec : specs) {
+    if (!names.emplace(spec.name, 1).second) {
+      throw std::runtime_error("'" + spec.name + "' is defined twice");
+    }
+    pairs.emplace_back(spec, window);
+  }
+  for (const Basket &basket : baskets) {
+    for (const std::string &symbol : basket.constituents()) {
+      if (auto found = names.find(symbol);
+          found != names.end() && found->second == 1) {
+        throw std::runtime_error("Basket '" + basket.name() +
+                                 "' cannot hold pair '" + symbol + "'");
+      }
+    }
+  }
+  return pairs;
+}
+
+/**
+ * @brief Builds every symbol's fan-out list: the pairs it is a leg of
+ * @return Legs by symbol; symbols in no pair have no entry
+ */
+inline std::unordered_map<std::string, std::vector<PairLeg>>
+pair_legs(const std::vector<PairSeries> &pairs) {
+  std::unordered_map<std::string, std::vector<PairLeg>> legs;
+  for (size_t p = 0; p < pairs.size(); ++p) {
+    const PairSpec &spec = pairs[p].legs();
+    legs[spec.first].push_back({static_cast<uint32_t>(p), 0});
+    legs[spec.second].push_back({static_cast<uint32_t>(p), 1});
+  }
+  return legs;
+}
+
+#endif
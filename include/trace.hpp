@@ -0,0 +1,170 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Reads the trace clock
+ * @return Steady-clock nanoseconds (shared by every thread)
+ */
+inline uint64_t trace_now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+/**
+ * @struct TraceEvent
+ * @brief One timed span: a stage of one batch, or any other unit of work
+ */
+struct TraceEvent {
+  const char *name; ///< Static string naming the span (e.g. "parse")
+  uint64_t begin_ns;
+  uint64_t end_ns;
+  uint64_t batch; ///< Batch number shown in the span's arguments
+};
+
+/**
+ * @class TraceBuffer
+ * @brief Append-only event storage owned by a single thread
+ *
+ * Events are stored in fixed-size chunks, so an append never moves earlier
+ * events and never takes a lock. The buffer is only read once its thread
+ * has stopped recording.
+ */
+class TraceBuffer {
+  static constexpr size_t CHUNK_EVENTS = 4096;
+  using Chunk = std::array<TraceEvent, CHUNK_EVENTS>;
+
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  size_t used = CHUNK_EVENTS; ///< Events used in the last chunk
+
+public:
+  std::string thread_name; ///< Shown as the track name in the viewer
+
+  /**
+   * @brief Appends an event (owner thread only)
+   */
+  void record(const char *name, uint64_t begin_ns, uint64_t end_ns,
+              uint64_t batch) {
+    if (used == CHUNK_EVENTS) {
+      chunks.push_back(std::make_unique<Chunk>());
+      used = 0;
+    }
+    (*chunks.back())[used++] = TraceEvent{name, begin_ns, end_ns, batch};
+  }
+
+  /**
+   * @brief Calls fn(event) for every recorded event in order
+   */
+  template <typename Fn> void for_each(Fn &&fn) const {
+    for (size_t c = 0; c < chunks.size(); ++c) {
+      const size_t count = c + 1 == chunks.size() ? used : CHUNK_EVENTS;
+      for (size_t i = 0; i < count; ++i) {
+        fn((*chunks[c])[i]);
+      }
+    }
+  }
+};
+
+/**
+ * @class TraceRecorder
+ * @brief Collects per-thread event buffers and writes a Chrome trace
+ *
+ * Each recording thread gets its own TraceBuffer on first use (the only
+ * time the registry lock is taken), so recording a span costs a clock read
+ * and a store. write() produces the Chrome trace-event JSON format read by
+ * Perfetto (ui.perfetto.dev) and chrome://tracing, with one track per
+ * thread.
+ */
+class TraceRecorder {
+  std::mutex registry_mutex; ///< Guards thread registration
+  std::vector<std::unique_ptr<TraceBuffer>> per_thread; ///< One per thread
+  std::unordered_map<std::thread::id, TraceBuffer *>
+      by_thread; ///< Each registered thread's buffer
+  uint64_t origin_ns = trace_now_ns(); ///< Timestamps are relative to this
+  uint64_t id = next_id(); ///< Never reused, unlike the recorder's address
+
+  /**
+   * @brief Returns a new recorder id (ids start at 1)
+   */
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> last{0};
+    return last.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+public:
+  /**
+   * @brief Returns the calling thread's buffer, registering it once
+   * @param thread_name Track name used if the thread is new
+   *
+   * Callers on a hot path should fetch this reference once and keep it.
+   * As in LatencyRecorder, the thread remembers the last recorder it used
+   * by id, not address, and a thread switching recorders is looked up in
+   * the registry rather than given a new buffer.
+   */
+  TraceBuffer &local(const char *thread_name) {
+    thread_local TraceBuffer *mine = nullptr;
+    thread_local uint64_t owner = 0;
+    if (owner != id) {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      TraceBuffer *&registered = by_thread[std::this_thread::get_id()];
+      if (registered == nullptr) {
+        per_thread.push_back(std::make_unique<TraceBuffer>());
+        registered = per_thread.back().get();
+        registered->thread_name = thread_name;
+      }
+      mine = registered;
+      owner = id;
+    }
+    return *mine;
+  }
+
+  /**
+   * @brief Writes every buffer as Chrome trace-event JSON
+   * @param out Destination stream
+   *
+   * Must only be called once every recording thread has finished. Spans are
+   * written as complete ("X") events with microsecond timestamps.
+   */
+  void write(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    char text[256];
+    for (size_t tid = 0; tid < per_thread.size(); ++tid) {
+      const TraceBuffer &buffer = *per_thread[tid];
+      std::snprintf(text, sizeof(text),
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", tid + 1, buffer.thread_name.c_str());
+      out << text;
+      first = false;
+      buffer.for_each([&](const TraceEvent &event) {
+        std::snprintf(text, sizeof(text),
+                      ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"batch\":%llu}}",
+                      event.name, tid + 1,
+                      (event.begin_ns - origin_ns) / 1e3,
+                      (event.end_ns - event.begin_ns) / 1e3,
+                      static_cast<unsigned long long>(event.batch));
+        out << text;
+      });
+    }
+    out << "\n]}\n";
+  }
+};
+
+#endif
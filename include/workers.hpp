@@ -0,0 +1,100 @@
+#ifndef WORKERS_HPP
+#define WORKERS_HPP
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkerPool
+ * @brief Fixed set of threads that split a range of work items between them
+ *
+ * run() hands every thread (the caller included) one contiguous block of
+ * the items and returns once all blocks are done. Threads are started once
+ * and wait on a barrier between calls, so a call costs two barrier phases
+ * rather than thread creation, which keeps per-batch parallelism cheap.
+ */
+class WorkerPool {
+  unsigned size;          ///< Threads, the caller included
+  std::barrier<> start;   ///< Releases the workers into a task
+  std::barrier<> done;    ///< Waits for every block of the task
+  std::vector<std::thread> workers;
+  const std::function<void(size_t, size_t)> *task = nullptr;
+  size_t task_items = 0;
+  bool stopping = false;
+
+  /**
+   * @brief Runs thread `index`'s block of the current task
+   */
+  void run_block(unsigned index) {
+    const size_t begin = task_items * index / size;
+    const size_t end = task_items * (index + 1) / size;
+    if (begin < end) {
+      (*task)(begin, end);
+    }
+  }
+
+public:
+  /**
+   * @brief Starts the workers
+   * @param threads Threads to split work between, the caller included; 0
+   * means one per hardware thread
+   */
+  explicit WorkerPool(unsigned threads)
+      : size(threads != 0 ? threads
+                          : std::max(1u, std::thread::hardware_concurrency())),
+        start(size), done(size) {
+    for (unsigned index = 1; index < size; ++index) {
+      workers.emplace_back([this, index] {
+        for (;;) {
+          start.arrive_and_wait();
+          if (stopping) {
+            return;
+          }
+          run_block(index);
+          done.arrive_and_wait();
+        }
+      });
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  ~WorkerPool() {
+    stopping = true;
+    start.arrive_and_wait();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief Returns the number of threads, the caller included
+   */
+  unsigned threads() const { return size; }
+
+  /**
+   * @brief Calls fn(begin, end) on disjoint blocks covering [0, items)
+   * @param items Number of work items
+   * @param fn Must not throw; blocks run concurrently on different threads
+   */
+  void run(size_t items, const std::function<void(size_t, size_t)> &fn) {
+    if (size == 1) {
+      if (items > 0) {
+        fn(0, items);
+      }
+      return;
+    }
+    task = &fn;
+    task_items = items;
+    start.arrive_and_wait();
+    run_block(0);
+    done.arrive_and_wait();
+  }
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef XSECTION_HPP
+#define XSECTION_HPP
+
+#include "indicators.hpp"
+#include "sink.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class CrossSection
+ * @brief Per-bucket statistics across symbols (--xsection)
+ *
+ * Every symbol's last price is kept in a dense array, indexed by the order
+ * in which symbols were first observed.
+ * When a trade arrives in a later bucket than the one open, the open bucket
+ * is closed: each symbol seen so far gets its return since the previous
+ * close (its first price, for a symbol new in the bucket), and the returns
+ * are ranked and z-scored across the universe with plain loops over the
+ * dense arrays. A symbol that did not trade in the bucket keeps its last
+ * price, i.e. a return of 0. A symbol whose previous close (or first
+ * price) is not positive has no return and is left out of the bucket.
+ * Buckets in which nothing traded print nothing.
+ *
+ * Per-symbol output (the default):
+ *   timestamp,symbol,price,return,rank,zscore[,sma,ema,volatility,vwap]
+ * where timestamp is the bucket's end, rank 1 is the highest return (ties
+ * in order of first appearance) and the indicator columns are the symbol's
+ * latest values, for the indicators enabled. Universe output (":universe"):
+ *   timestamp,symbols,mean_return,dispersion,min_return,max_return,
+ *   advancers,decliners
+ * where dispersion is the cross-sectional standard deviation of returns.
+ */
+class CrossSection {
+  int64_t bucket_ns;       ///< Bucket length
+  bool universe;           ///< Summaries instead of per-symbol rows
+  ResultColumns columns;   ///< Indicator columns of per-symbol rows
+  std::ostream &out;       ///< Destination
+  int64_t bucket = std::numeric_limits<int64_t>::min(); ///< Open bucket
+  bool traded = false;     ///< Anything traded in the open bucket
+
+  static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> slots;         ///< Slot by symbol id, or NO_SLOT
+  std::vector<const Series *> series;  ///< By slot
+  std::vector<std::string_view> names; ///< By slot
+  std::vector<double> last;            ///< Last price, by slot
+  std::vector<double> base;            ///< Previous close, by slot
+  std::vector<double> returns;         ///< Bucket returns, by slot
+  std::vector<uint32_t> active;        ///< Slots with a positive base
+  std::vector<uint32_t> order;         ///< Slots by descending return
+  std::vector<uint32_t> rank;          ///< Rank, by slot
+  std::string buffer;                  ///< Text of the bucket
+
+  /**
+   * @brief Appends a comma and a value to the buffer
+   */
+  void field(double value) {
+    buffer += ',';
+    buffer += std::to_string(value);
+  }
+
+  /**
+   * @brief Computes and prints the open bucket's cross-section
+   */
+  void close_bucket() {
+    // A return from a price that is not positive is undefined, and one NaN
+    // would spoil the bucket's statistics and its ranking
+    active.clear();
+    returns.resize(last.size());
+    for (size_t i = 0; i < last.size(); ++i) {
+      if (base[i] > 0) {
+        returns[i] = last[i] / base[i] - 1.0;
+        active.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    const size_t n = active.size();
+    if (n == 0) {
+      base = last;
+      traded = false;
+      return;
+    }
+    double sum = 0.0;
+    for (const uint32_t i : active) {
+      sum += returns[i];
+    }
+    const double mean = sum / static_cast<double>(n);
+    double sum_sq = 0.0;
+    for (const uint32_t i : active) {
+      sum_sq += (returns[i] - mean) * (returns[i] - mean);
+    }
+    const double dispersion = std::sqrt(sum_sq / static_cast<double>(n));
+    const std::string timestamp = format_timestamp_ns((bucket + 1) *
+                                                      bucket_ns);
+
+    if (universe) {
+      double low = returns[active[0]];
+      double high = low;
+      size_t advancers = 0;
+      size_t decliners = 0;
+      for (const uint32_t i : active) {
+        low = std::min(low, returns[i]);
+        high = std::max(high, returns[i]);
+        advancers += returns[i] > 0;
+        decliners += returns[i] < 0;
+      }
+      buffer += timestamp;
+      buffer += ',' + std::to_string(n);
+      field(mean);
+      field(dispersion);
+      field(low);
+      field(high);
+      buffer += ',' + std::to_string(advancers);
+      buffer += ',' + std::to_string(decliners);
+      buffer += '\n';
+    } else {
+      order = active;
+      std::stable_sort(order.begin(), order.end(),
+                       [this](uint32_t a, uint32_t b) {
+                         return returns[a] > returns[b];
+                       });
+      rank.resize(last.size());
+      for (size_t r = 0; r < n; ++r) {
+        rank[order[r]] = static_cast<uint32_t>(r + 1);
+      }
+      for (const uint32_t i : active) {
+        const double z =
+            dispersion > 0 ? (returns[i] - mean) / dispersion : 0.0;
+        buffer += timestamp;
+        buffer += ',';
+        buffer += names[i];
+        field(last[i]);
+        field(returns[i]);
+        buffer += ',' + std::to_string(rank[i]);
+        field(z);
+        if (columns.sma) {
+          field(series[i]->get_indicator(IndicatorType::SMA));
+        }
+        if (columns.ema) {
+          field(series[i]->get_indicator(IndicatorType::EMA));
+        }
+        if (columns.volatility) {
+          field(series[i]->get_indicator(IndicatorType::VOLATILITY));
+        }
+        if (columns.vwap) {
+          field(series[i]->get_indicator(IndicatorType::VWAP));
+        }
+        buffer += '\n';
+      }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+
+    base = last;
+    traded = false;
+  }
+
+public:
+  /**
+   * @brief Creates a cross-section
+   * @param length Bucket length in nanoseconds
+   * @param summaries Print universe summaries instead of per-symbol rows
+   * @param indicator_columns Indicators added to per-symbol rows
+   * @param destination Where the text goes
+   */
+  CrossSection(int64_t length, bool summaries,
+               const ResultColumns &indicator_columns,
+               std::ostream &destination)
+      : bucket_ns(length), universe(summaries), columns(indicator_columns),
+        out(destination) {}
+
+  /**
+   * @brief Prints the header
+   */
+  void begin() {
+    if (universe) {
+      out << "timestamp,symbols,mean_return,dispersion,min_return,"
+             "max_return,advancers,decliners\n";
+      return;
+    }
+    std::string header = "timestamp,symbol,price,return,rank,zscore";
+    header += columns.sma ? ",sma" : "";
+    header += columns.ema ? ",ema" : "";
+    header += columns.volatility ? ",volatility" : "";
+    header += columns.vwap ? ",vwap" : "";
+    out << header << '\n';
+  }
+
+  /**
+   * @brief Records a trade, before its symbol's indicators are updated
+   * @param id The symbol's id
+   * @param name The symbol's name (must stay valid)
+   * @param symbol_series The symbol's indicators (must stay valid)
+   * @param ts_ns The trade's time; a trade in a later bucket first closes
+   * the open one, a trade in an earlier bucket counts towards the open one
+   * @param price The trade's price
+   */
+  void observe(uint32_t id, std::string_view name,
+               const Series &symbol_series, int64_t ts_ns, double price) {
+    const int64_t trade_bucket =
+        ts_ns >= 0 ? ts_ns / bucket_ns : -((-ts_ns - 1) / bucket_ns) - 1;
+    if (trade_bucket > bucket) {
+      if (traded) {
+        close_bucket();
+      }
+      bucket = trade_bucket;
+    }
+    if (id >= slots.size()) {
+      slots.resize(id + 1, NO_SLOT);
+    }
+    if (slots[id] == NO_SLOT) {
+      slots[id] = static_cast<uint32_t>(last.size());
+      series.push_back(&symbol_series);
+      names.push_back(name);
+      last.push_back(price);
+      base.push_back(price);
+    }
+    last[slots[id]] = price;
+    traded = true;
+  }
+
+  /**
+   * @brief Closes the last bucket at the end of the input
+   */
+  void finish() {
+    if (traded) {
+      close_bucket();
+    }
+    out.flush();
+  }
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "../include/priceanalytics.h"
+#include "../include/engine.hpp"
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @class ColumnSink
+ * @brief Appends every output batch to contiguous, engine-owned columns
+ */
+class ColumnSink : public ResultSink {
+public:
+  ResultColumns columns;            ///< Indicator columns enabled
+  std::vector<int64_t> ts_ns;       ///< PA_COLUMN_TIMESTAMP
+  std::vector<uint32_t> symbol_ids; ///< PA_COLUMN_SYMBOL
+  std::vector<double> prices;       ///< PA_COLUMN_PRICE
+  std::vector<int64_t> volumes;     ///< PA_COLUMN_VOLUME
+  std::vector<double> sma;          ///< PA_COLUMN_SMA
+  std::vector<double> ema;          ///< PA_COLUMN_EMA
+  std::vector<double> volatility;   ///< PA_COLUMN_VOLATILITY
+  std::vector<double> vwap;         ///< PA_COLUMN_VWAP
+  std::vector<double> zscore;       ///< PA_COLUMN_ZSCORE
+  std::deque<std::string> names;    ///< Symbol names by id (stable c_str())
+
+  void begin(const ResultColumns &enabled) override { columns = enabled; }
+
+  void write(const ResultBatch &batch) override {
+    for (size_t id = names.size(); id < batch.symbols.size(); ++id) {
+      names.emplace_back(batch.symbols[id]);
+    }
+    for (std::string_view timestamp : batch.timestamps) {
+      int64_t value;
+      if (!parse_timestamp_ns(timestamp, value)) {
+        value = std::numeric_limits<int64_t>::min();
+      }
+      ts_ns.push_back(value);
+    }
+    symbol_ids.insert(symbol_ids.end(), batch.symbol_ids.begin(),
+                      batch.symbol_ids.end());
+    prices.insert(prices.end(), batch.prices.begin(), batch.prices.end());
+    volumes.insert(volumes.end(), batch.volumes.begin(), batch.volumes.end());
+    sma.insert(sma.end(), batch.sma.begin(), batch.sma.end());
+    ema.insert(ema.end(), batch.ema.begin(), batch.ema.end());
+    volatility.insert(volatility.end(), batch.volatility.begin(),
+                      batch.volatility.end());
+    vwap.insert(vwap.end(), batch.vwap.begin(), batch.vwap.end());
+    zscore.insert(zscore.end(), batch.zscore.begin(), batch.zscore.end());
+  }
+
+  /**
+   * @brief Drops the rows (symbol names are kept, ids stay valid)
+   */
+  void clear() {
+    ts_ns.clear();
+    symbol_ids.clear();
+    prices.clear();
+    volumes.clear();
+    sma.clear();
+    ema.clear();
+    volatility.clear();
+    vwap.clear();
+    zscore.clear();
+  }
+};
+
+/**
+ * @struct pa_engine
+ * @brief An Engine writing into a ColumnSink
+ */
+struct pa_engine {
+  ColumnSink sink; ///< Declared first: the engine writes into it
+  Engine engine;
+
+  explicit pa_engine(const CLIConfig &config) : engine(config) {
+    engine.set_sink(sink);
+  }
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+/**
+ * @brief Runs a C API body, turning exceptions into -1 and pa_last_error()
+ */
+template <typename Body> int guarded(Body &&body) {
+  try {
+    body();
+    last_error.clear();
+    return 0;
+  } catch (const std::exception &e) {
+    last_error = e.what();
+  } catch (...) {
+    last_error = "Unknown error";
+  }
+  return -1;
+}
+
+/**
+ * @brief Parses a space-separated flag string with the command-line parser
+ */
+CLIConfig parse_flags(const char *flags) {
+  std::vector<std::string> words{"priceanalytics"};
+  std::istringstream in(flags ? flags : "");
+  for (std::string word; in >> word;) {
+    words.push_back(std::move(word));
+  }
+  std::vector<char *> argv;
+  for (std::string &word : words) {
+    argv.push_back(word.data());
+  }
+  return parse_cli_args(static_cast<int>(argv.size()), argv.data());
+}
+
+} // namespace
+
+extern "C" {
+
+int pa_api_version(void) { return PA_API_VERSION; }
+
+pa_engine *pa_engine_create(const char *flags) {
+  pa_engine *engine = nullptr;
+  guarded([&] { engine = new pa_engine(parse_flags(flags)); });
+  return engine;
+}
+
+void pa_engine_destroy(pa_engine *engine) { delete engine; }
+
+int pa_engine_process_file(pa_engine *engine, const char *path) {
+  return guarded([&] {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      throw std::runtime_error("Cannot open file '" + std::string(path) +
+                               "'");
+    }
+    std::vector<char> chunk(1 << 20);
+    const auto chunk_size = static_cast<std::streamsize>(chunk.size());
+    while (file.read(chunk.data(), chunk_size) || file.gcount() > 0) {
+      engine->engine.push(
+          std::string_view(chunk.data(), static_cast<size_t>(file.gcount())));
+    }
+    if (file.bad()) {
+      throw std::runtime_error("Cannot read file '" + std::string(path) +
+                               "'");
+    }
+    engine->engine.finish();
+  });
+}
+
+int pa_engine_push(pa_engine *engine, const char *data, size_t length) {
+  return guarded(
+      [&] { engine->engine.push(std::string_view(data, length)); });
+}
+
+int pa_engine_finish(pa_engine *engine) {
+  return guarded([&] { engine->engine.finish(); });
+}
+
+size_t pa_result_rows(const pa_engine *engine) {
+  return engine->sink.prices.size();
+}
+
+int pa_result_column(const pa_engine *engine, pa_column column,
+                     const void **data, size_t *length) {
+  const ColumnSink &sink = engine->sink;
+  const void *start = nullptr;
+  bool enabled = true;
+  switch (column) {
+  case PA_COLUMN_TIMESTAMP:
+    start = sink.ts_ns.data();
+    break;
+  case PA_COLUMN_SYMBOL:
+    start = sink.symbol_ids.data();
+    break;
+  case PA_COLUMN_PRICE:
+    start = sink.prices.data();
+    break;
+  case PA_COLUMN_VOLUME:
+    start = sink.volumes.data();
+    break;
+  case PA_COLUMN_SMA:
+    start = sink.sma.data();
+    enabled = sink.columns.sma;
+    break;
+  case PA_COLUMN_EMA:
+    start = sink.ema.data();
+    enabled = sink.columns.ema;
+    break;
+  case PA_COLUMN_VOLATILITY:
+    start = sink.volatility.data();
+    enabled = sink.columns.volatility;
+    break;
+  case PA_COLUMN_VWAP:
+    start = sink.vwap.data();
+    enabled = sink.columns.vwap;
+    break;
+  case PA_COLUMN_ZSCORE:
+    start = sink.zscore.data();
+    enabled = sink.columns.zscore;
+    break;
+  default:
+    last_error = "Unknown column";
+    return -1;
+  }
+  if (!enabled) {
+    last_error = "Indicator column not enabled";
+    return -1;
+  }
+  *data = start;
+  *length = sink.prices.size();
+  last_error.clear();
+  return 0;
+}
+
+void pa_result_clear(pa_engine *engine) { engine->sink.clear(); }
+
+size_t pa_symbol_count(const pa_engine *engine) {
+  return engine->sink.names.size();
+}
+
+const char *pa_symbol_name(const pa_engine *engine, uint32_t id) {
+  const auto &names = engine->sink.names;
+  return id < names.size() ? names[id].c_str() : nullptr;
+}
+
+const char *pa_last_error(void) { return last_error.c_str(); }
+
+} // extern "C"
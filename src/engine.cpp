@@ -0,0 +1,110 @@
+#include "../include/engine.hpp"
+#include "../include/analyzer.hpp"
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @class RowCallbackSink
+ * @brief Sink that hands each row of a batch to an Engine's row callback
+ */
+class RowCallbackSink : public ResultSink {
+public:
+  Engine::RowCallback callback;
+
+  void write(const ResultBatch &batch) override {
+    if (!callback) {
+      return;
+    }
+    auto value = [](std::span<const double> column, size_t i) {
+      return column.empty() ? 0.0 : column[i];
+    };
+    for (size_t i = 0; i < batch.size; ++i) {
+      callback(EngineRow{batch.timestamps[i],
+                         batch.symbols[batch.symbol_ids[i]], batch.prices[i],
+                         batch.volumes[i], value(batch.sma, i),
+                         value(batch.ema, i), value(batch.volatility, i),
+                         value(batch.vwap, i), value(batch.zscore, i)});
+    }
+  }
+};
+
+/**
+ * @struct Engine::Impl
+ * @brief The analyzer behind an Engine, kept out of the public header
+ */
+struct Engine::Impl {
+  CLIConfig config;
+  CSVAnalyzer analyzer;
+  RowCallbackSink callback_sink;
+
+  /**
+   * @brief Rejects options an engine cannot honour: those that replace rows
+   * with text of their own, which would go to the host's stdout instead of
+   * the callback or sink, and --latency, whose reports are never printed
+   */
+  static const CLIConfig &checked(const CLIConfig &config) {
+    if (config.xsection_ns > 0) {
+      throw std::invalid_argument("--xsection is not available in an engine");
+    }
+    if (config.summary) {
+      throw std::invalid_argument("--summary is not available in an engine");
+    }
+    if (!config.bar_kind.empty()) {
+      throw std::invalid_argument("--bars is not available in an engine");
+    }
+    if (config.report_latency) {
+      throw std::invalid_argument("--latency is not available in an engine");
+    }
+    if (!config.sweep_indicator.empty()) {
+      throw std::invalid_argument("--sweep is not available in an engine");
+    }
+    if (!config.backtest_indicator.empty()) {
+      throw std::invalid_argument("--backtest is not available in an engine");
+    }
+    if (!config.config_file.empty()) {
+      throw std::invalid_argument(
+          "--config-file is not available in an engine");
+    }
+    if (!config.as_of_symbol.empty()) {
+      throw std::invalid_argument("--as-of is not available in an engine");
+    }
+    return config;
+  }
+
+  explicit Impl(const CLIConfig &engine_config)
+      : config(checked(engine_config)), analyzer(config) {
+    if (!analyzer.open_outputs()) {
+      throw std::runtime_error("Cannot create the engine's output files");
+    }
+    analyzer.set_sink(callback_sink);
+  }
+};
+
+Engine::Engine(const CLIConfig &config)
+    : impl(std::make_unique<Impl>(config)) {}
+
+Engine::~Engine() = default;
+Engine::Engine(Engine &&) noexcept = default;
+Engine &Engine::operator=(Engine &&) noexcept = default;
+
+void Engine::on_row(RowCallback callback) {
+  impl->callback_sink.callback = std::move(callback);
+  impl->analyzer.set_sink(impl->callback_sink);
+}
+
+void Engine::set_sink(ResultSink &sink) {
+  sink.begin(ResultColumns::from_config(impl->config));
+  impl->analyzer.set_sink(sink);
+}
+
+void Engine::push(std::string_view bytes) { impl->analyzer.push(bytes); }
+
+void Engine::finish() { impl->analyzer.finish_push(); }
+
+uint64_t Engine::lines() const {
+  return impl->analyzer.parse_stats().total_lines;
+}
+
+uint64_t Engine::parse_failures() const {
+  return impl->analyzer.parse_stats().parse_failures;
+}
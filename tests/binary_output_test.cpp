@@ -0,0 +1,62 @@
+#include "../include/indicators.hpp"
+#include "../include/sink.hpp"
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file binary_output_test.cpp
+ * @brief Decodes `analyzer --output=binary` and prints it as CSV
+ *
+ * Reads the stream with BinaryResultReader and formats every batch through
+ * CsvSink, so for inputs with whole-second timestamps the output equals the
+ * analyzer's CSV output byte for byte.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude \
+ *       -o binary_output_test tests/binary_output_test.cpp
+ *   ./analyzer --output=binary [flags] data.csv > results.bin
+ *   ./binary_output_test results.bin
+ */
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: binary_output_test results.bin\n";
+    return 1;
+  }
+  try {
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open file '" << argv[1] << "'\n";
+      return 1;
+    }
+    BinaryResultReader reader(file);
+    CsvSink sink(std::cout);
+    sink.begin(reader.columns);
+
+    std::vector<std::string> timestamps;
+    std::vector<std::string_view> timestamp_views;
+    std::vector<std::string_view> symbols;
+    while (reader.next()) {
+      const size_t n = reader.prices.size();
+      timestamps.clear();
+      timestamp_views.clear();
+      for (int64_t ts_ns : reader.ts_ns) {
+        timestamps.push_back(format_timestamp_ns(ts_ns));
+      }
+      timestamp_views.assign(timestamps.begin(), timestamps.end());
+      symbols.assign(reader.symbols.begin(), reader.symbols.end());
+      sink.write({n, timestamp_views, reader.symbol_ids, symbols,
+                  reader.prices, reader.volumes, reader.sma, reader.ema,
+                  reader.volatility, reader.vwap, reader.zscore});
+      sink.commit(false);
+    }
+    return 0;
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << '\n';
+    return 1;
+  }
+}
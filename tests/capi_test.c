@@ -0,0 +1,77 @@
+#include "../include/priceanalytics.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Runs a CSV file through the C API and prints every result row as
+ * "symbol,price,volume[,indicators...]" with six decimals, i.e. the
+ * analyzer's CSV output without the header and timestamp column. Compiled
+ * as C to check that the header is valid C.
+ *
+ * Build and run:
+ *   gcc -std=c11 -Iinclude -c tests/capi_test.c -o capi_test.o
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o capi_test \
+ *       capi_test.o src/capi.cpp src/engine.cpp
+ *   ./capi_test "--sma=20 --vwap=daily" filename.csv
+ */
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: capi_test FLAGS filename.csv\n");
+    return 1;
+  }
+  if (pa_api_version() != PA_API_VERSION) {
+    fprintf(stderr, "Error: library API version mismatch\n");
+    return 1;
+  }
+
+  pa_engine *engine = pa_engine_create(argv[1]);
+  if (!engine) {
+    fprintf(stderr, "Error: %s\n", pa_last_error());
+    return 1;
+  }
+  if (pa_engine_process_file(engine, argv[2]) != 0) {
+    fprintf(stderr, "Error: %s\n", pa_last_error());
+    pa_engine_destroy(engine);
+    return 1;
+  }
+
+  const void *data;
+  size_t rows;
+  pa_result_column(engine, PA_COLUMN_SYMBOL, &data, &rows);
+  const uint32_t *symbols = data;
+  pa_result_column(engine, PA_COLUMN_PRICE, &data, &rows);
+  const double *prices = data;
+  pa_result_column(engine, PA_COLUMN_VOLUME, &data, &rows);
+  const int64_t *volumes = data;
+  pa_result_column(engine, PA_COLUMN_TIMESTAMP, &data, &rows);
+
+  const double *indicators[5];
+  size_t count = 0;
+  for (int column = PA_COLUMN_SMA; column <= PA_COLUMN_ZSCORE; ++column) {
+    if (pa_result_column(engine, (pa_column)column, &data, &rows) == 0) {
+      indicators[count++] = data;
+    }
+  }
+  if (pa_result_column(engine, (pa_column)99, &data, &rows) == 0 ||
+      strlen(pa_last_error()) == 0) {
+    fprintf(stderr, "Error: unknown column accepted\n");
+    return 1;
+  }
+
+  for (size_t i = 0; i < rows; ++i) {
+    printf("%s,%f,%lld", pa_symbol_name(engine, symbols[i]), prices[i],
+           (long long)volumes[i]);
+    for (size_t k = 0; k < count; ++k) {
+      printf(",%f", indicators[k][i]);
+    }
+    printf("\n");
+  }
+
+  pa_result_clear(engine);
+  if (pa_result_rows(engine) != 0) {
+    fprintf(stderr, "Error: rows left after pa_result_clear\n");
+    return 1;
+  }
+  pa_engine_destroy(engine);
+  return 0;
+}
@@ -0,0 +1,807 @@
+#include "../include/analyzer.hpp"
+#include "../include/csv.hpp"
+#include "../include/indicators.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file differential_test.cpp
+ * @brief Differential fuzzer: optimized analyzer paths against a reference
+ *
+ * The reference namespace keeps the original, obviously-correct
+ * implementations: indicators that recompute from their whole window with
+ * std::accumulate and a two-pass variance, and a parser that splits into
+ * strings and converts with std::stod/std::stol. Random inputs (random
+ * walks, flat stretches, jumps, day changes, malformed lines) and random
+ * configurations are run through both, and the largest ULP and relative
+ * error per indicator is reported.
+ *
+ * Four layers are compared:
+ *   - parse: CSVAnalyzer::parse_line() against reference::parse_line()
+ *   - series: every Series indicator after every update
+ *   - batch: Series::update_batch() in random chunk sizes against the
+ *     row-by-row Series, which must agree bit for bit
+ *   - pipeline: the full process_stream() output against rows formatted
+ *     from the reference engine
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude \
+ *       -o differential_test tests/differential_test.cpp
+ *   ./differential_test [--cases=N] [--rows=N] [--seed=S] [--tolerance=R]
+ *
+ * Exits with status 1 if any comparison exceeds the tolerance.
+ */
+
+namespace reference {
+
+/**
+ * @brief Simple moving average recomputed from the whole window
+ */
+class SMA {
+  std::deque<double> prices;
+  size_t window_size;
+
+public:
+  explicit SMA(size_t window) : window_size(window) {}
+
+  void update(double price) {
+    prices.push_back(price);
+    if (prices.size() > window_size) {
+      prices.pop_front();
+    }
+  }
+
+  double value() const {
+    if (prices.empty()) {
+      return 0.0;
+    }
+    return std::accumulate(prices.begin(), prices.end(), 0.0) /
+           static_cast<double>(prices.size());
+  }
+};
+
+/**
+ * @brief Exponential moving average seeded with the first price
+ */
+class EMA {
+  double current = 0.0;
+  double alpha;
+  bool first = true;
+
+public:
+  explicit EMA(double smoothing_factor) : alpha(smoothing_factor) {}
+
+  void update(double price) {
+    if (first) {
+      current = price;
+      first = false;
+    } else {
+      current = alpha * price + (1 - alpha) * current;
+    }
+  }
+
+  double value() const { return current; }
+};
+
+/**
+ * @brief Sample standard deviation of returns with a two-pass variance
+ */
+class Volatility {
+  std::deque<double> returns;
+  size_t window_size;
+
+public:
+  explicit Volatility(size_t window) : window_size(window) {}
+
+  void update(double return_val) {
+    returns.push_back(return_val);
+    if (returns.size() > window_size) {
+      returns.pop_front();
+    }
+  }
+
+  double value() const {
+    if (returns.size() < 2) {
+      return 0.0;
+    }
+    const double n = static_cast<double>(returns.size());
+    const double mean =
+        std::accumulate(returns.begin(), returns.end(), 0.0) / n;
+    double sum_squared_diffs = 0.0;
+    for (double r : returns) {
+      sum_squared_diffs += (r - mean) * (r - mean);
+    }
+    return std::sqrt(sum_squared_diffs / (n - 1));
+  }
+
+  /**
+   * @brief Root mean square of the returns in the window (error scale)
+   */
+  double rms() const {
+    double sum_squares = 0.0;
+    for (double r : returns) {
+      sum_squares += r * r;
+    }
+    return returns.empty() ? 0.0 : std::sqrt(sum_squares / returns.size());
+  }
+};
+
+/**
+ * @brief Volume-weighted average price, reset when the date changes
+ */
+class VWAP {
+  double price_volume_sum = 0.0;
+  long volume_sum = 0;
+  std::string current_date;
+
+public:
+  void update(double price, long volume, const std::string &timestamp) {
+    std::string date = timestamp.substr(0, 10);
+    if (date != current_date) {
+      price_volume_sum = 0.0;
+      volume_sum = 0;
+      current_date = date;
+    }
+    price_volume_sum += price * volume;
+    volume_sum += volume;
+  }
+
+  double value() const {
+    return volume_sum == 0 ? 0.0 : price_volume_sum / volume_sum;
+  }
+};
+
+/**
+ * @brief The four indicators of one symbol, fed like ::Series
+ */
+class Series {
+  SMA sma;
+  EMA ema;
+  Volatility volatility;
+  VWAP vwap;
+  double last_price = 0.0;
+
+public:
+  Series(int sma_window, double ema_alpha, int vol_window)
+      : sma(sma_window), ema(ema_alpha), volatility(vol_window) {}
+
+  void update(double price, long volume, const std::string &timestamp) {
+    if (last_price == 0) {
+      last_price = price;
+      return;
+    }
+    sma.update(price);
+    ema.update(price);
+    volatility.update(price / last_price - 1.0);
+    vwap.update(price, volume, timestamp);
+    last_price = price;
+  }
+
+  double return_rms() const { return volatility.rms(); }
+
+  double get(IndicatorType type) const {
+    switch (type) {
+    case IndicatorType::SMA:
+      return sma.value();
+    case IndicatorType::EMA:
+      return ema.value();
+    case IndicatorType::VOLATILITY:
+      return volatility.value();
+    default:
+      return vwap.value();
+    }
+  }
+};
+
+/**
+ * @brief Parses a line by splitting it into strings
+ *
+ * Same rules as the analyzer: at least four fields, the whole price field
+ * is a number, the volume field starts with an integer, and everything
+ * after the fourth comma is an action only if it is exactly "X" or "A";
+ * anything else there is ignored.
+ */
+inline ParsedRow parse_line(const std::string &line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (fields.size() < 4) {
+    size_t comma = line.find(',', start);
+    if (comma == std::string::npos) {
+      fields.push_back(line.substr(start));
+      break;
+    }
+    fields.push_back(line.substr(start, comma - start));
+    start = comma + 1;
+    if (fields.size() == 4) {
+      fields.push_back(line.substr(start)); // Rest of the line
+    }
+  }
+  if (fields.size() < 4) {
+    return ParsedRow::invalid();
+  }
+
+  ParsedRow row{fields[0], fields[1], 0.0, 0, true};
+  try {
+    size_t used = 0;
+    row.price = std::stod(fields[2], &used);
+    if (used != fields[2].size()) {
+      return ParsedRow::invalid();
+    }
+    row.volume = std::stol(fields[3], &used);
+  } catch (const std::exception &) {
+    return ParsedRow::invalid();
+  }
+
+  if (fields.size() == 5 && fields[4] == "X") {
+    row.action = RowAction::CANCEL;
+  } else if (fields.size() == 5 && fields[4] == "A") {
+    row.action = RowAction::AMEND;
+  }
+  return row;
+}
+
+} // namespace reference
+
+/**
+ * @brief Distance between two doubles in units in the last place
+ *
+ * Maps each value's bits onto a monotonic integer line, so adjacent doubles
+ * (including across zero) are 1 apart.
+ */
+inline uint64_t ulp_distance(double a, double b) {
+  if (std::isnan(a) || std::isnan(b)) {
+    return std::isnan(a) && std::isnan(b) ? 0 : UINT64_MAX;
+  }
+  auto ordered = [](double x) {
+    int64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits < 0 ? INT64_MIN - bits : bits;
+  };
+  const int64_t ia = ordered(a);
+  const int64_t ib = ordered(b);
+  return ia > ib ? static_cast<uint64_t>(ia) - static_cast<uint64_t>(ib)
+                 : static_cast<uint64_t>(ib) - static_cast<uint64_t>(ia);
+}
+
+/**
+ * @struct ErrorStats
+ * @brief Worst-case error of one indicator over every compared sample
+ *
+ * Relative error is taken against a scale supplied with each sample: the
+ * reference value itself for price-like indicators, but for volatility the
+ * size of the returns it was computed from (at least 1e-6), so a volatility
+ * that should be exactly zero (a flat price) is not judged by an infinite
+ * relative error.
+ * ULPs are only counted where the reference value sets the scale.
+ */
+struct ErrorStats {
+  const char *name;       ///< Indicator or layer name
+  double tolerance;       ///< Largest acceptable relative error
+  uint64_t samples = 0;   ///< Values compared
+  uint64_t failures = 0;  ///< Values beyond the tolerance
+  uint64_t max_ulp = 0;   ///< Largest ULP distance
+  double max_rel = 0.0;   ///< Largest relative error
+  std::string worst = ""; ///< Description of the largest relative error
+
+  /**
+   * @brief Compares one optimized value against its reference
+   * @param scale Magnitude the error is relative to (at least |expected|)
+   * @return true if within tolerance
+   */
+  bool add(double optimized, double expected, double scale,
+           const std::string &context) {
+    samples++;
+    scale = std::max({scale, std::fabs(expected), 1e-300});
+    double rel = std::fabs(optimized - expected) / scale;
+    if (std::isnan(rel)) {
+      rel = ulp_distance(optimized, expected) == 0 ? 0.0 : INFINITY;
+    }
+    if (std::fabs(expected) >= scale) {
+      max_ulp = std::max(max_ulp, ulp_distance(optimized, expected));
+    }
+    if (rel > max_rel) {
+      max_rel = rel;
+      char text[160];
+      std::snprintf(text, sizeof(text), "got %.17g, expected %.17g", optimized,
+                    expected);
+      worst = context + ": " + text;
+    }
+    if (rel > tolerance) {
+      failures++;
+      return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * @struct FuzzConfig
+ * @brief Parameters of one fuzz case
+ */
+struct FuzzConfig {
+  int sma_window;
+  int ema_span;
+  int vol_window;
+  size_t symbols;
+  std::string filter_symbol; ///< Empty for no filter
+};
+
+/**
+ * @class DifferentialFuzzer
+ * @brief Generates random cases and compares the optimized and reference
+ * engines on them
+ */
+class DifferentialFuzzer {
+  static constexpr IndicatorType INDICATORS[] = {
+      IndicatorType::SMA, IndicatorType::EMA, IndicatorType::VOLATILITY,
+      IndicatorType::VWAP};
+
+  std::mt19937_64 rng;
+  std::vector<ErrorStats> series_stats;
+  ErrorStats pipeline_stats;
+  uint64_t parse_samples = 0;
+  uint64_t parse_mismatches = 0;
+  uint64_t pipeline_row_mismatches = 0;
+  uint64_t batch_samples = 0;
+  uint64_t batch_mismatches = 0;
+  std::string first_parse_mismatch;
+  std::string first_batch_mismatch;
+  std::string first_pipeline_mismatch;
+
+  double uniform(double lo, double hi) {
+    return std::uniform_real_distribution<double>(lo, hi)(rng);
+  }
+  size_t below(size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+  }
+  bool chance(double p) { return uniform(0.0, 1.0) < p; }
+
+  /**
+   * @brief One symbol's trades in the form update_batch() takes, with the
+   * row-by-row Series values after each
+   */
+  struct BatchInput {
+    std::vector<double> prices;
+    std::vector<int64_t> volumes;
+    std::vector<int64_t> ts;
+    std::vector<std::array<double, 4>> scalar;
+  };
+
+  /**
+   * @brief Picks window sizes from small edge cases up to long windows
+   */
+  int random_window() {
+    static constexpr int EDGES[] = {1, 2, 3};
+    return chance(0.2) ? EDGES[below(3)] : static_cast<int>(1 + below(500));
+  }
+
+  FuzzConfig random_config() {
+    FuzzConfig config;
+    config.sma_window = random_window();
+    config.ema_span = random_window();
+    config.vol_window = random_window();
+    config.symbols = 1 + below(chance(0.5) ? 3 : 50);
+    if (chance(0.2)) {
+      config.filter_symbol = "S" + std::to_string(below(config.symbols));
+    }
+    return config;
+  }
+
+  /**
+   * @brief Generates the lines of one case
+   *
+   * Each symbol follows a random walk whose scale and step size vary per
+   * symbol, with flat stretches, large jumps and day changes mixed in. A few
+   * percent of lines are malformed or corrections.
+   */
+  std::vector<std::string> random_lines(const FuzzConfig &config,
+                                        size_t rows) {
+    struct Walk {
+      double price;
+      double step;
+      int decimals;
+    };
+    std::vector<Walk> walks(config.symbols);
+    for (Walk &walk : walks) {
+      walk.price = std::pow(10.0, uniform(-3.0, 5.0));
+      walk.step = std::pow(10.0, uniform(-6.0, -1.0));
+      walk.decimals = static_cast<int>(below(9));
+    }
+
+    std::vector<std::string> lines;
+    lines.reserve(rows);
+    int day = 1;
+    int64_t seconds = 9 * 3600;
+    char text[128];
+    for (size_t i = 0; i < rows; ++i) {
+      if (chance(0.002)) {
+        day = day % 28 + 1;
+        seconds = 9 * 3600;
+      }
+      seconds += static_cast<int64_t>(below(3));
+      const size_t symbol = below(config.symbols);
+      Walk &walk = walks[symbol];
+      if (chance(0.01)) {
+        walk.price *= chance(0.5) ? 10.0 : 0.1; // Jump
+      } else if (!chance(0.1)) {                // Otherwise a flat tick
+        walk.price *= std::exp(walk.step * uniform(-1.0, 1.0));
+      }
+      const long volume = chance(0.05) ? 0 : static_cast<long>(below(1000000));
+      std::snprintf(text, sizeof(text),
+                    "2024-03-%02d %02d:%02d:%02d,S%zu,%.*f,%ld", day,
+                    static_cast<int>(seconds / 3600 % 24),
+                    static_cast<int>(seconds / 60 % 60),
+                    static_cast<int>(seconds % 60), symbol, walk.decimals,
+                    walk.price, volume);
+      std::string line = text;
+      if (chance(0.03)) {
+        line = mutate(line);
+      }
+      lines.push_back(std::move(line));
+    }
+    return lines;
+  }
+
+  /**
+   * @brief Damages a line or turns it into a correction
+   */
+  std::string mutate(const std::string &line) {
+    const size_t comma = line.rfind(',');
+    switch (below(9)) {
+    case 0:
+      return line.substr(0, comma); // Missing volume
+    case 1:
+      return line + ",X";
+    case 2:
+      return line + ",A";
+    case 3:
+      return line + ",Z"; // Not an action: a trade
+    case 4:
+      return line + ",,extra";
+    case 5:
+      return line + ",X,extra"; // Extra columns: a trade
+    case 6:
+      return line.substr(0, comma) + ",12abc"; // Volume with trailing junk
+    case 7: {
+      const size_t price = line.rfind(',', comma - 1);
+      return line.substr(0, price) + ",1.5x" + line.substr(comma);
+    }
+    default:
+      return line.substr(0, line.find(',')) + ",S0,,100"; // Empty price
+    }
+  }
+
+  void compare_parse(CSVAnalyzer &analyzer, const std::string &line,
+                     const ParsedRow &expected) {
+    const ParsedRow row = analyzer.parse_line(line);
+    parse_samples++;
+    const bool same =
+        row.is_valid == expected.is_valid &&
+        (!row.is_valid ||
+         (row.timestamp == expected.timestamp &&
+          row.symbol == expected.symbol &&
+          ulp_distance(row.price, expected.price) == 0 &&
+          row.volume == expected.volume && row.action == expected.action));
+    if (!same) {
+      parse_mismatches++;
+      if (first_parse_mismatch.empty()) {
+        first_parse_mismatch = line;
+      }
+    }
+  }
+
+  /**
+   * @brief Runs one case through the parser, Series and full pipeline
+   */
+  void run_case(size_t case_number, size_t rows) {
+    const FuzzConfig fuzz = random_config();
+    const std::vector<std::string> lines = random_lines(fuzz, rows);
+
+    CLIConfig config;
+    config.sma_window = fuzz.sma_window;
+    config.ema_span = fuzz.ema_span;
+    config.vol_window = fuzz.vol_window;
+    config.output_sma = config.output_ema = true;
+    config.output_vol = config.output_vwap = true;
+    config.filter_symbol = fuzz.filter_symbol;
+    // Some analyzers record latency or a trace, at the previous one's address
+    config.report_latency = case_number % 2 == 0;
+    config.trace_filename = case_number % 3 == 0 ? "/dev/null" : "";
+    CSVAnalyzer analyzer(config);
+    const double alpha = span_to_alpha(fuzz.ema_span);
+
+    std::unordered_map<std::string, Series> optimized;
+    std::unordered_map<std::string, reference::Series> expected;
+    std::vector<std::array<double, 4>> expected_rows;
+    std::vector<std::string> expected_base;
+    std::unordered_map<std::string, BatchInput> batches;
+    for (size_t i = 0; i < lines.size(); ++i) {
+      const ParsedRow row = reference::parse_line(lines[i]);
+      compare_parse(analyzer, lines[i], row);
+      if (!row.is_valid || row.action != RowAction::TRADE ||
+          (!fuzz.filter_symbol.empty() && row.symbol != fuzz.filter_symbol)) {
+        continue;
+      }
+
+      Series &series =
+          optimized
+              .try_emplace(row.symbol, fuzz.sma_window, alpha, fuzz.vol_window)
+              .first->second;
+      reference::Series &oracle =
+          expected
+              .try_emplace(row.symbol, fuzz.sma_window, alpha, fuzz.vol_window)
+              .first->second;
+      series.update(row.price, row.volume, row.timestamp);
+      oracle.update(row.price, row.volume, row.timestamp);
+
+      BatchInput &batch = batches[row.symbol];
+      int64_t ts_ns = 0;
+      parse_timestamp_ns(row.timestamp, ts_ns);
+      batch.prices.push_back(row.price);
+      batch.volumes.push_back(row.volume);
+      batch.ts.push_back(ts_ns);
+      std::array<double, 4> scalar;
+      for (size_t k = 0; k < 4; ++k) {
+        scalar[k] = series.get_indicator(INDICATORS[k]);
+      }
+      batch.scalar.push_back(scalar);
+
+      std::array<double, 4> values;
+      for (size_t k = 0; k < 4; ++k) {
+        values[k] = oracle.get(INDICATORS[k]);
+        // Returns below a hundredth of a basis point count as flat
+        const double scale = INDICATORS[k] == IndicatorType::VOLATILITY
+                                 ? std::max(oracle.return_rms(), 1e-6)
+                                 : 0.0;
+        series_stats[k].add(series.get_indicator(INDICATORS[k]), values[k],
+                            scale,
+                            "case " + std::to_string(case_number) + " line " +
+                                std::to_string(i + 1));
+      }
+      expected_rows.push_back(values);
+      expected_base.push_back(row.timestamp + ',' + row.symbol + ',' +
+                              std::to_string(row.price) + ',' +
+                              std::to_string(row.volume));
+    }
+
+    for (const auto &[symbol, batch] : batches) {
+      compare_batch(batch, fuzz, alpha, case_number);
+    }
+    compare_pipeline(analyzer, lines, expected_base, expected_rows,
+                     case_number);
+  }
+
+  /**
+   * @brief Runs one symbol's trades through Series::update_batch() in
+   * random chunks, with random outputs left empty, and compares every
+   * value written with the row-by-row result
+   */
+  void compare_batch(const BatchInput &batch, const FuzzConfig &fuzz,
+                     double alpha, size_t case_number) {
+    Series series(fuzz.sma_window, alpha, fuzz.vol_window);
+    const size_t n = batch.prices.size();
+    std::array<std::vector<double>, 4> values;
+    std::array<bool, 4> wanted;
+    for (size_t k = 0; k < 4; ++k) {
+      wanted[k] = !chance(0.2);
+      values[k].assign(n, NAN);
+    }
+    auto span_of = [&](size_t k, size_t offset, size_t count) {
+      return wanted[k] ? std::span<double>(values[k]).subspan(offset, count)
+                       : std::span<double>();
+    };
+    for (size_t offset = 0; offset < n;) {
+      const size_t limit = chance(0.5) ? 4 : 600;
+      const size_t count = std::min(n - offset, 1 + below(limit));
+      series.update_batch(
+          std::span<const double>(batch.prices).subspan(offset, count),
+          std::span<const int64_t>(batch.volumes).subspan(offset, count),
+          std::span<const int64_t>(batch.ts).subspan(offset, count),
+          OutputSpans{span_of(0, offset, count), span_of(1, offset, count),
+                      span_of(2, offset, count), span_of(3, offset, count)});
+      offset += count;
+    }
+    for (size_t row = 0; row < n; ++row) {
+      for (size_t k = 0; k < 4; ++k) {
+        if (!wanted[k]) {
+          continue;
+        }
+        batch_samples++;
+        if (ulp_distance(values[k][row], batch.scalar[row][k]) != 0) {
+          batch_mismatches++;
+          if (first_batch_mismatch.empty()) {
+            first_batch_mismatch = "case " + std::to_string(case_number) +
+                                   " row " + std::to_string(row + 1) +
+                                   " indicator " + std::to_string(k);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Compares process_stream() output with the reference rows
+   *
+   * Output is printed with six decimals, so indicator cells are compared
+   * with an absolute error of up to 5e-7 plus the relative tolerance.
+   */
+  void compare_pipeline(CSVAnalyzer &analyzer,
+                        const std::vector<std::string> &lines,
+                        const std::vector<std::string> &expected_base,
+                        const std::vector<std::array<double, 4>> &expected,
+                        size_t case_number) {
+    std::string input;
+    for (const std::string &line : lines) {
+      input += line;
+      input += '\n';
+    }
+    std::istringstream in(input);
+    std::ostringstream out;
+    std::ostringstream warnings;
+    std::streambuf *saved_out = std::cout.rdbuf(out.rdbuf());
+    std::streambuf *saved_err = std::cerr.rdbuf(warnings.rdbuf());
+    analyzer.process_stream(in);
+    std::cout.rdbuf(saved_out);
+    std::cerr.rdbuf(saved_err);
+
+    std::istringstream produced(out.str());
+    std::string line;
+    std::getline(produced, line); // Header
+    size_t row = 0;
+    auto mismatch = [&](const std::string &what) {
+      pipeline_row_mismatches++;
+      if (first_pipeline_mismatch.empty()) {
+        first_pipeline_mismatch =
+            "case " + std::to_string(case_number) + " row " +
+            std::to_string(row + 1) + ": " + what;
+      }
+    };
+    for (; std::getline(produced, line); ++row) {
+      if (row >= expected.size()) {
+        mismatch("unexpected extra row");
+        return;
+      }
+      // Base columns are the first four fields
+      size_t cut = 0;
+      for (int commas = 0; commas < 4; ++commas) {
+        cut = line.find(',', cut) + 1;
+      }
+      if (line.compare(0, cut - 1, expected_base[row]) != 0) {
+        mismatch(line);
+        continue;
+      }
+      const char *cell = line.c_str() + cut;
+      for (size_t k = 0; k < 4; ++k) {
+        char *end;
+        const double value = std::strtod(cell, &end);
+        const double scale = std::max(std::fabs(expected[row][k]), 1.0);
+        const double error = std::fabs(value - expected[row][k]);
+        pipeline_stats.add(value, expected[row][k], scale, "pipeline");
+        if (error > 5e-7 + series_stats[k].tolerance * scale) {
+          mismatch(line);
+        }
+        cell = end + 1;
+      }
+    }
+    if (row != expected.size()) {
+      mismatch(std::to_string(expected.size() - row) + " rows missing");
+    }
+  }
+
+public:
+  /**
+   * @param seed Random seed (cases are reproducible per seed)
+   * @param tolerance Relative tolerance for SMA, EMA and VWAP
+   * @param vol_tolerance Relative tolerance for volatility
+   */
+  DifferentialFuzzer(uint64_t seed, double tolerance, double vol_tolerance)
+      : rng(seed), series_stats{{"sma", tolerance},
+                                {"ema", tolerance},
+                                {"volatility", vol_tolerance},
+                                {"vwap", tolerance}},
+        pipeline_stats{"pipeline", INFINITY} {} // Judged per cell instead
+
+  void run(size_t cases, size_t rows) {
+    for (size_t c = 1; c <= cases; ++c) {
+      run_case(c, rows);
+    }
+  }
+
+  /**
+   * @brief Prints the error table and returns true if everything passed
+   */
+  bool report(std::ostream &out) const {
+    bool passed = parse_mismatches == 0 && pipeline_row_mismatches == 0 &&
+                  batch_mismatches == 0;
+    char text[160];
+    out << "layer/indicator      samples   max ulp   max rel err  failures\n";
+    auto print = [&](const ErrorStats &stats) {
+      std::snprintf(text, sizeof(text), "%-16s %11llu %9llu %13.3e %9llu\n",
+                    stats.name, static_cast<unsigned long long>(stats.samples),
+                    static_cast<unsigned long long>(stats.max_ulp),
+                    stats.max_rel,
+                    static_cast<unsigned long long>(stats.failures));
+      out << text;
+      passed = passed && stats.failures == 0;
+    };
+    for (const ErrorStats &stats : series_stats) {
+      print(stats);
+    }
+    std::snprintf(text, sizeof(text), "%-16s %11llu %9s %13s %9llu\n", "parse",
+                  static_cast<unsigned long long>(parse_samples), "-", "-",
+                  static_cast<unsigned long long>(parse_mismatches));
+    out << text;
+    std::snprintf(text, sizeof(text), "%-16s %11llu %9s %13s %9llu\n", "batch",
+                  static_cast<unsigned long long>(batch_samples), "-", "-",
+                  static_cast<unsigned long long>(batch_mismatches));
+    out << text;
+    std::snprintf(text, sizeof(text), "%-16s %11llu %9s %13.3e %9llu\n",
+                  "pipeline",
+                  static_cast<unsigned long long>(pipeline_stats.samples), "-",
+                  pipeline_stats.max_rel,
+                  static_cast<unsigned long long>(pipeline_row_mismatches));
+    out << text;
+
+    for (const ErrorStats &stats : series_stats) {
+      if (!stats.worst.empty()) {
+        out << "worst " << stats.name << ": " << stats.worst << '\n';
+      }
+    }
+    if (!first_parse_mismatch.empty()) {
+      out << "first parse mismatch: " << first_parse_mismatch << '\n';
+    }
+    if (!first_batch_mismatch.empty()) {
+      out << "first batch mismatch: " << first_batch_mismatch << '\n';
+    }
+    if (!first_pipeline_mismatch.empty()) {
+      out << "first pipeline mismatch: " << first_pipeline_mismatch << '\n';
+    }
+    return passed;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  size_t cases = 200;
+  size_t rows = 2000;
+  uint64_t seed = 1;
+  double tolerance = 1e-9;
+  double vol_tolerance = 1e-7;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--cases=", 0) == 0) {
+      cases = std::stoul(arg.substr(8));
+    } else if (arg.rfind("--rows=", 0) == 0) {
+      rows = std::stoul(arg.substr(7));
+    } else if (arg.rfind("--seed=", 0) == 0) {
+      seed = std::stoull(arg.substr(7));
+    } else if (arg.rfind("--tolerance=", 0) == 0) {
+      tolerance = std::stod(arg.substr(12));
+    } else if (arg.rfind("--vol-tolerance=", 0) == 0) {
+      vol_tolerance = std::stod(arg.substr(16));
+    } else {
+      std::cerr << "Usage: differential_test [--cases=N] [--rows=N] "
+                   "[--seed=S] [--tolerance=R] [--vol-tolerance=R]\n";
+      return 1;
+    }
+  }
+
+  DifferentialFuzzer fuzzer(seed, tolerance, vol_tolerance);
+  fuzzer.run(cases, rows);
+  const bool passed = fuzzer.report(std::cout);
+  std::cout << (passed ? "PASS" : "FAIL") << " (" << cases << " cases, seed "
+            << seed << ")\n";
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,580 @@
+#include "../include/csv.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file generate_test_data.cpp
+ * @brief Fast, deterministic synthetic market-data generator
+ *
+ * Produces "timestamp,symbol,price,volume" rows in the analyzer's input
+ * format. Symbols are drawn from a Zipf distribution, prices follow a
+ * per-symbol geometric random walk, and rows can optionally be swapped out of
+ * order or corrupted to exercise --max-lateness and malformed-row handling.
+ *
+ * Rows are generated in fixed-size chunks, each with its own random stream
+ * derived from the seed and the chunk number, so the output depends only on
+ * the options and never on the thread count. Each block of chunks is built in
+ * three passes: draw symbols, returns and volumes (parallel), advance the
+ * price walks (sequential, since a symbol's walk spans chunks), then format
+ * text (parallel). Blocks are written in order, keeping memory bounded.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -pthread -o generate_test_data \
+ *       tests/generate_test_data.cpp
+ *   ./generate_test_data --rows=100000000 --symbols=100000 \
+ *       --output=tests/data/huge.csv
+ */
+
+/**
+ * @struct GeneratorConfig
+ * @brief Options of one generator run
+ */
+struct GeneratorConfig {
+  uint64_t rows = 5000000;    ///< Rows to generate
+  uint32_t symbols = 10;      ///< Distinct symbols (1 to 1M)
+  double zipf_exponent = 1.0; ///< Zipf exponent of symbol activity (0 =
+                              ///< uniform)
+  uint64_t seed = 42;         ///< Seed; equal seeds give identical output
+  int decimals = 2;           ///< Price decimals
+  double tick_volatility = 0.001; ///< Standard deviation of per-tick returns
+  int64_t interval_ns = 1'000'000'000; ///< Time between consecutive rows
+  std::string start = "2023-09-15 09:30:00"; ///< Timestamp of the first row
+  double out_of_order = 0.0; ///< Fraction of rows swapped with the next row
+  double malformed = 0.0;    ///< Fraction of rows replaced by malformed text
+  unsigned threads = 0;      ///< Worker threads (0 = hardware concurrency)
+  std::string output = "-";  ///< Output path ("-" = standard output)
+};
+
+/**
+ * @brief Mixes a 64-bit value (SplitMix64 finalizer)
+ *
+ * Used to derive independent per-chunk seeds from the run seed.
+ */
+inline uint64_t mix_seed(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * @class Xoshiro256
+ * @brief xoshiro256** generator: much faster than std::mt19937_64 and fine
+ * for synthetic data
+ */
+class Xoshiro256 {
+  uint64_t state[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+  using result_type = uint64_t;
+  static constexpr uint64_t min() { return 0; }
+  static constexpr uint64_t max() { return ~uint64_t{0}; }
+
+  explicit Xoshiro256(uint64_t seed) {
+    for (auto &word : state) {
+      seed = mix_seed(seed);
+      word = seed;
+    }
+  }
+
+  uint64_t operator()() {
+    const uint64_t result = rotl(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+  /**
+   * @brief Uniform integer in [0, n) (multiply-shift, negligible bias)
+   */
+  uint32_t below(uint32_t n) {
+    return static_cast<uint32_t>(((*this)() >> 32) * n >> 32);
+  }
+
+  /**
+   * @brief Uniform double in [0, 1)
+   */
+  double unit() { return ((*this)() >> 11) * 0x1.0p-53; }
+};
+
+/**
+ * @class AliasTable
+ * @brief Walker alias table: O(1) sampling from a discrete distribution
+ */
+class AliasTable {
+  std::vector<double> probability; ///< Chance of keeping the drawn column
+  std::vector<uint32_t> alias;     ///< Column taken otherwise
+
+public:
+  /**
+   * @brief Builds the table for the given (unnormalized) weights
+   */
+  explicit AliasTable(const std::vector<double> &weights)
+      : probability(weights.size()), alias(weights.size()) {
+    const size_t n = weights.size();
+    double total = 0.0;
+    for (double w : weights) {
+      total += w;
+    }
+
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * n / total;
+      (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+      uint32_t s = small.back(), l = large.back();
+      small.pop_back();
+      probability[s] = scaled[s];
+      alias[s] = l;
+      scaled[l] -= 1.0 - scaled[s];
+      if (scaled[l] < 1.0) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // Leftovers are 1.0 up to rounding error
+    for (uint32_t i : small) {
+      probability[i] = 1.0;
+    }
+    for (uint32_t i : large) {
+      probability[i] = 1.0;
+    }
+  }
+
+  /**
+   * @brief Draws an index
+   */
+  uint32_t sample(Xoshiro256 &rng) const {
+    uint32_t i = rng.below(static_cast<uint32_t>(alias.size()));
+    return rng.unit() < probability[i] ? i : alias[i];
+  }
+};
+
+/**
+ * @brief Runs fn(i) for i in [0, count) on up to `threads` threads
+ */
+template <typename Fn>
+void parallel_for(size_t count, unsigned threads, const Fn &fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads && t < count; ++t) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : pool) {
+    thread.join();
+  }
+}
+
+/**
+ * @class MarketDataGenerator
+ * @brief Generates the rows described by a GeneratorConfig
+ */
+class MarketDataGenerator {
+public:
+  static constexpr size_t CHUNK_ROWS = 65536; ///< Rows per random stream
+  static constexpr size_t BLOCK_CHUNKS = 16;  ///< Chunks generated at once
+  static constexpr size_t MAX_ROW_BYTES = 96; ///< Longest formatted row
+
+private:
+  /**
+   * @struct Chunk
+   * @brief Draws and formatted text of one chunk
+   */
+  struct Chunk {
+    std::vector<uint32_t> symbol; ///< Symbol of each row
+    std::vector<double> step;     ///< Log return of each row
+    std::vector<uint32_t> volume; ///< Volume of each row
+    std::vector<double> price;    ///< Price after each row
+    std::vector<uint8_t> flags;   ///< SWAP_NEXT / MALFORMED per row
+    std::string text;             ///< Formatted rows
+  };
+
+  static constexpr uint8_t SWAP_NEXT = 1; ///< Emit after the following row
+  static constexpr uint8_t MALFORMED = 2; ///< Replace with a malformed line
+
+  GeneratorConfig config;         ///< Options of the run
+  AliasTable activity;            ///< Zipf symbol activity
+  std::vector<std::string> names; ///< Symbol names
+  std::vector<double> last_price; ///< Current price of each symbol
+  int64_t start_ns = 0;           ///< First row's time since the epoch
+  int64_t price_scale = 1;        ///< 10^decimals
+
+  static std::vector<double> zipf_weights(uint32_t n, double exponent) {
+    std::vector<double> weights(n);
+    for (uint32_t k = 0; k < n; ++k) {
+      weights[k] = 1.0 / std::pow(k + 1.0, exponent);
+    }
+    return weights;
+  }
+
+  /**
+   * @brief Draws symbols, returns, volumes and flags of one chunk
+   */
+  void draw(Chunk &chunk, uint64_t chunk_index, size_t rows) const {
+    Xoshiro256 rng(config.seed ^ mix_seed(chunk_index));
+    std::normal_distribution<double> step(0.0, config.tick_volatility);
+
+    chunk.symbol.resize(rows);
+    chunk.step.resize(rows);
+    chunk.volume.resize(rows);
+    chunk.price.resize(rows);
+    chunk.flags.assign(rows, 0);
+    for (size_t i = 0; i < rows; ++i) {
+      chunk.symbol[i] = activity.sample(rng);
+      chunk.step[i] = step(rng);
+      chunk.volume[i] = 100 + rng.below(4901);
+      if (config.malformed > 0 && rng.unit() < config.malformed) {
+        chunk.flags[i] |= MALFORMED;
+      }
+      // Swaps stay inside the chunk and never overlap
+      if (config.out_of_order > 0 && i + 1 < rows &&
+          !(i > 0 && (chunk.flags[i - 1] & SWAP_NEXT)) &&
+          rng.unit() < config.out_of_order) {
+        chunk.flags[i] |= SWAP_NEXT;
+      }
+    }
+  }
+
+  /**
+   * @brief Advances each row's symbol's random walk (must run in row order)
+   */
+  void walk(Chunk &chunk) {
+    for (size_t i = 0; i < chunk.symbol.size(); ++i) {
+      double &price = last_price[chunk.symbol[i]];
+      price *= std::exp(chunk.step[i]);
+      chunk.price[i] = price;
+    }
+  }
+
+  /**
+   * @brief Writes a non-negative integer, returning the end of the text
+   */
+  static char *write_uint(char *out, uint64_t value) {
+    return std::to_chars(out, out + 20, value).ptr;
+  }
+
+  /**
+   * @brief Writes an integer zero-padded to `width` digits
+   */
+  static char *write_padded(char *out, uint64_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+      out[i] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    }
+    return out + width;
+  }
+
+  /**
+   * @brief Writes "YYYY-MM-DD " for a day number since 1970-01-01
+   */
+  static char *write_date(char *out, int64_t days) {
+    // Civil date from days since the epoch (inverse of parse_timestamp_ns)
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2);
+
+    out = write_padded(out, year, 4);
+    *out++ = '-';
+    out = write_padded(out, month, 2);
+    *out++ = '-';
+    out = write_padded(out, day, 2);
+    *out++ = ' ';
+    return out;
+  }
+
+  /**
+   * @struct DateCache
+   * @brief The formatted date of the last day written (rows share days)
+   */
+  struct DateCache {
+    int64_t day = std::numeric_limits<int64_t>::min(); ///< Day number of `text`
+    char text[11];           ///< "YYYY-MM-DD "
+  };
+
+  /**
+   * @brief Writes "YYYY-MM-DD HH:MM:SS[.mmm]" for a row number
+   */
+  char *write_timestamp(char *out, uint64_t row, DateCache &date) const {
+    int64_t ns = start_ns + static_cast<int64_t>(row) * config.interval_ns;
+    int64_t seconds = ns / 1'000'000'000;
+    int64_t days = seconds / 86400;
+    int64_t second_of_day = seconds % 86400;
+
+    if (days != date.day) {
+      write_date(date.text, days);
+      date.day = days;
+    }
+    std::memcpy(out, date.text, sizeof(date.text));
+    out += sizeof(date.text);
+    out = write_padded(out, second_of_day / 3600, 2);
+    *out++ = ':';
+    out = write_padded(out, second_of_day / 60 % 60, 2);
+    *out++ = ':';
+    out = write_padded(out, second_of_day % 60, 2);
+    if (config.interval_ns % 1'000'000'000 != 0) {
+      *out++ = '.';
+      out = write_padded(out, ns % 1'000'000'000 / 1'000'000, 3);
+    }
+    return out;
+  }
+
+  /**
+   * @brief Writes a string
+   */
+  static char *write_text(char *out, const std::string &text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+  }
+
+  /**
+   * @brief Writes one row (or its malformed replacement) including '\n'
+   */
+  char *write_row(char *out, const Chunk &chunk, size_t i, uint64_t row,
+                  DateCache &date) const {
+    const std::string &name = names[chunk.symbol[i]];
+    if (chunk.flags[i] & MALFORMED) {
+      // Cycle through the kinds of damage real feeds show
+      switch (row % 3) {
+      case 0:
+        return write_text(out, "garbage,,\n");
+      case 1:
+        out = write_timestamp(out, row, date);
+        *out++ = ',';
+        out = write_text(out, name);
+        return write_text(out, ",n/a,100\n");
+      default:
+        out = write_text(out, name);
+        *out++ = '\n';
+        return out;
+      }
+    }
+
+    out = write_timestamp(out, row, date);
+    *out++ = ',';
+    out = write_text(out, name);
+    *out++ = ',';
+    int64_t ticks = std::llround(chunk.price[i] * price_scale);
+    out = write_uint(out, static_cast<uint64_t>(ticks / price_scale));
+    if (config.decimals > 0) {
+      *out++ = '.';
+      out = write_padded(out, static_cast<uint64_t>(ticks % price_scale),
+                         config.decimals);
+    }
+    *out++ = ',';
+    out = write_uint(out, chunk.volume[i]);
+    *out++ = '\n';
+    return out;
+  }
+
+  /**
+   * @brief Formats a chunk whose first row is `first_row`
+   */
+  void format(Chunk &chunk, uint64_t first_row) const {
+    const size_t rows = chunk.symbol.size();
+    chunk.text.resize(rows * MAX_ROW_BYTES);
+    char *out = chunk.text.data();
+    DateCache date;
+    for (size_t i = 0; i < rows; ++i) {
+      if ((chunk.flags[i] & SWAP_NEXT) && i + 1 < rows) {
+        out = write_row(out, chunk, i + 1, first_row + i + 1, date);
+        out = write_row(out, chunk, i, first_row + i, date);
+        ++i;
+      } else {
+        out = write_row(out, chunk, i, first_row + i, date);
+      }
+    }
+    chunk.text.resize(static_cast<size_t>(out - chunk.text.data()));
+  }
+
+public:
+  /**
+   * @brief Prepares symbol names, activity table and starting prices
+   * @throws std::invalid_argument on out-of-range options
+   */
+  explicit MarketDataGenerator(const GeneratorConfig &cfg)
+      : config(cfg), activity(zipf_weights(cfg.symbols, cfg.zipf_exponent)) {
+    if (!parse_timestamp_ns(config.start, start_ns)) {
+      throw std::invalid_argument("Invalid --start timestamp");
+    }
+    for (int d = 0; d < config.decimals; ++d) {
+      price_scale *= 10;
+    }
+
+    std::mt19937_64 rng(mix_seed(config.seed));
+    std::uniform_real_distribution<double> base(10.0, 500.0);
+    names.reserve(config.symbols);
+    last_price.reserve(config.symbols);
+    for (uint32_t s = 0; s < config.symbols; ++s) {
+      names.push_back("SYM" + std::to_string(s));
+      last_price.push_back(base(rng));
+    }
+  }
+
+  /**
+   * @brief Generates every row into out
+   */
+  void run(std::ostream &out) {
+    unsigned threads = config.threads != 0
+                           ? config.threads
+                           : std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t total_chunks = (config.rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    std::vector<Chunk> block(BLOCK_CHUNKS);
+
+    for (uint64_t first = 0; first < total_chunks; first += BLOCK_CHUNKS) {
+      const size_t count =
+          static_cast<size_t>(std::min<uint64_t>(BLOCK_CHUNKS,
+                                                 total_chunks - first));
+      auto rows_in = [&](size_t c) {
+        uint64_t begin = (first + c) * CHUNK_ROWS;
+        return static_cast<size_t>(
+            std::min<uint64_t>(CHUNK_ROWS, config.rows - begin));
+      };
+
+      parallel_for(count, threads,
+                   [&](size_t c) { draw(block[c], first + c, rows_in(c)); });
+      for (size_t c = 0; c < count; ++c) {
+        walk(block[c]);
+      }
+      parallel_for(count, threads, [&](size_t c) {
+        format(block[c], (first + c) * CHUNK_ROWS);
+      });
+      for (size_t c = 0; c < count; ++c) {
+        out.write(block[c].text.data(),
+                  static_cast<std::streamsize>(block[c].text.size()));
+      }
+    }
+    out.flush();
+  }
+};
+
+/**
+ * @brief Parses --key=value options into a GeneratorConfig
+ * @throws std::invalid_argument on unknown or invalid options
+ */
+GeneratorConfig parse_generator_args(int argc, char *argv[]) {
+  GeneratorConfig config;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto eq_pos = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq_pos == std::string::npos) {
+      throw std::invalid_argument("Invalid flag format: " + arg +
+                                  " (use --key=value)");
+    }
+    std::string key = arg.substr(2, eq_pos - 2);
+    std::string value = arg.substr(eq_pos + 1);
+
+    if (key == "rows") {
+      config.rows = std::stoull(value);
+    } else if (key == "symbols") {
+      long symbols = std::stol(value);
+      if (symbols < 1 || symbols > 1000000) {
+        throw std::invalid_argument("--symbols must be between 1 and 1000000");
+      }
+      config.symbols = static_cast<uint32_t>(symbols);
+    } else if (key == "zipf") {
+      config.zipf_exponent = std::stod(value);
+    } else if (key == "seed") {
+      config.seed = std::stoull(value);
+    } else if (key == "decimals") {
+      config.decimals = std::stoi(value);
+      if (config.decimals < 0 || config.decimals > 8) {
+        throw std::invalid_argument("--decimals must be between 0 and 8");
+      }
+    } else if (key == "volatility") {
+      config.tick_volatility = std::stod(value);
+    } else if (key == "interval") {
+      config.interval_ns = parse_duration_ns(value);
+      if (config.interval_ns <= 0) {
+        throw std::invalid_argument("--interval must be positive");
+      }
+    } else if (key == "start") {
+      config.start = value;
+    } else if (key == "out-of-order") {
+      config.out_of_order = std::stod(value);
+    } else if (key == "malformed") {
+      config.malformed = std::stod(value);
+    } else if (key == "threads") {
+      config.threads = static_cast<unsigned>(std::stoul(value));
+    } else if (key == "output") {
+      config.output = value;
+    } else {
+      throw std::invalid_argument("Unknown key: " + key);
+    }
+  }
+  return config;
+}
+
+/**
+ * @brief Entry point: generates rows to a file or standard output
+ *
+ * Options (all --key=value):
+ *   --rows=N          Rows to generate (default 5000000)
+ *   --symbols=N       Distinct symbols, 1 to 1000000 (default 10)
+ *   --zipf=S          Zipf exponent of symbol activity, 0 = uniform (1.0)
+ *   --seed=N          Random seed (default 42)
+ *   --decimals=D      Price decimals, 0 to 8 (default 2)
+ *   --volatility=X    Per-tick return standard deviation (default 0.001)
+ *   --interval=T      Time between rows, e.g. "1s", "250ms" (default 1s)
+ *   --start=TS        First timestamp (default "2023-09-15 09:30:00")
+ *   --out-of-order=P  Fraction of rows swapped with the next row
+ *   --malformed=P     Fraction of rows replaced by malformed lines
+ *   --threads=N       Worker threads (default: all cores)
+ *   --output=PATH     Output file (default "-" = standard output)
+ */
+int main(int argc, char *argv[]) {
+  std::ios::sync_with_stdio(false);
+  try {
+    GeneratorConfig config = parse_generator_args(argc, argv);
+    MarketDataGenerator generator(config);
+
+    if (config.output == "-") {
+      generator.run(std::cout);
+    } else {
+      std::ofstream file(config.output, std::ios::binary);
+      if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file '" << config.output << "'\n";
+        return 1;
+      }
+      generator.run(file);
+      std::cerr << "Generated " << config.rows << " rows in " << config.output
+                << '\n';
+    }
+    return 0;
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -138,9 +138,458 @@ else
 fi
 rm -f tests/temp_bad_data.csv
 
+# Test 9: Latency reporting on streamed input
+echo "Test 9: Latency reporting..."
+cat tests/data/small_test.csv | ./analyzer --sma=3 --latency=0 - > tests/output_test9.csv 2> tests/output_test9_err.csv
+if [ $? -eq 0 ]; then
+    line_count=$(wc -l < tests/output_test9.csv)
+    if [ $line_count -eq 6 ] && grep -q "p99.9" tests/output_test9_err.csv; then
+        print_result 0 "Latency reporting (stdin input, percentiles on stderr)"
+    else
+        print_result 1 "Latency reporting (missing rows or latency report)"
+    fi
+else
+    print_result 1 "Latency reporting (analyzer crashed)"
+fi
+
+# Test 10: Out-of-order ticks are reordered, late ticks routed aside
+echo "Test 10: Reorder buffer..."
+echo "2023-09-15 09:30:00,AAPL,150.00,1000" > tests/temp_ooo_data.csv
+echo "2023-09-15 09:30:02,AAPL,152.00,1000" >> tests/temp_ooo_data.csv
+echo "2023-09-15 09:30:01,AAPL,151.00,1000" >> tests/temp_ooo_data.csv
+echo "2023-09-15 09:30:09,AAPL,159.00,1000" >> tests/temp_ooo_data.csv
+echo "2023-09-15 09:30:03,AAPL,153.00,1000" >> tests/temp_ooo_data.csv
+
+reorder_ok=0
+./analyzer --max-lateness=1s --late-output=tests/output_test10_late.csv tests/temp_ooo_data.csv > tests/output_test10.csv 2>/dev/null || reorder_ok=1
+order=$(tail -n +2 tests/output_test10.csv | cut -d, -f3 | tr '\n' ' ')
+late=$(cut -d, -f3 tests/output_test10_late.csv 2>/dev/null)
+if [[ $order != "150.000000 151.000000 152.000000 159.000000 " ]] || [[ $late != "153.00" ]]; then
+    reorder_ok=1
+fi
+# The watermark is shared: a quiet symbol's row is released as the others
+# move on, and a row behind another symbol's newest tick is late
+printf '%s\n' "2023-09-15 09:30:00,AAA,10.00,100" "2023-09-15 09:30:05,BBB,20.00,100" \
+    "2023-09-15 09:30:02,AAA,11.00,100" "2023-09-15 09:30:06,BBB,21.00,100" > tests/temp_ooo_data.csv
+if [ "$(./analyzer --max-lateness=1s tests/temp_ooo_data.csv 2>/dev/null | tail -n +2 | cut -d, -f2,3 | tr '\n' ' ')" != \
+     "AAA,10.000000 BBB,20.000000 BBB,21.000000 " ]; then
+    reorder_ok=1
+fi
+# A row whose timestamp cannot be parsed is routed aside too, not dropped
+printf '%s\n' "2023-09-15 09:30:00,AAA,10.00,100" "2023-09-15 9:3x,AAA,11.00,100" > tests/temp_ooo_data.csv
+./analyzer --max-lateness=1s --late-output=tests/output_test10_late.csv tests/temp_ooo_data.csv > tests/output_test10.csv 2> tests/output_test10_err.csv
+if [ "$(cat tests/output_test10_late.csv)" != "2023-09-15 9:3x,AAA,11.00,100" ] ||
+   ! grep -q "1 rows had no valid timestamp" tests/output_test10_err.csv; then
+    reorder_ok=1
+fi
+print_result $reorder_ok "Reorder buffer (rows sorted, late ticks routed aside)"
+rm -f tests/temp_ooo_data.csv
+
+# Test 11: Trade corrections match a run over the corrected data
+echo "Test 11: Trade corrections..."
+echo "2023-09-15 09:30:00,AAPL,150.00,1000" > tests/temp_corr_data.csv
+echo "2023-09-15 09:30:01,AAPL,151.00,1000" >> tests/temp_corr_data.csv
+echo "2023-09-15 09:30:02,AAPL,999.00,1000" >> tests/temp_corr_data.csv
+echo "2023-09-15 09:30:03,AAPL,153.00,1000" >> tests/temp_corr_data.csv
+echo "2023-09-15 09:30:02,AAPL,152.00,2000,A" >> tests/temp_corr_data.csv
+echo "2023-09-15 09:30:01,AAPL,151.00,1000,X" >> tests/temp_corr_data.csv
+echo "2023-09-15 09:30:04,AAPL,154.00,1000" >> tests/temp_corr_data.csv
+grep -v ",[AX]$" tests/temp_corr_data.csv | grep -v "09:30:01" | sed "s/999.00,1000/152.00,2000/" > tests/temp_corr_ref.csv
+
+./analyzer --sma=3 --ema=3 --vol=3 --vwap=daily --corrections=2 tests/temp_corr_data.csv > tests/output_test11.csv 2>/dev/null
+if [ $? -eq 0 ]; then
+    ./analyzer --sma=3 --ema=3 --vol=3 --vwap=daily tests/temp_corr_ref.csv > tests/output_test11_ref.csv
+    if [ "$(tail -1 tests/output_test11.csv)" == "$(tail -1 tests/output_test11_ref.csv)" ]; then
+        print_result 0 "Trade corrections (state matches corrected input)"
+    else
+        print_result 1 "Trade corrections (state differs from corrected input)"
+    fi
+else
+    print_result 1 "Trade corrections (analyzer crashed)"
+fi
+rm -f tests/temp_corr_data.csv tests/temp_corr_ref.csv
+
+# Test 12: As-of query from a snapshot index matches the full run
+echo "Test 12: As-of query..."
+./analyzer --sma=2 --vwap=daily --build-index=tests/output_test12.idx --index-every=1 tests/data/small_test.csv > tests/output_test12_full.csv 2>/dev/null
+if [ $? -eq 0 ]; then
+    expected=$(grep ",AAPL," tests/output_test12_full.csv | sed -n 2p)
+    as_of_ts=$(echo "$expected" | cut -d, -f1)
+    actual=$(./analyzer --sma=2 --vwap=daily --index=tests/output_test12.idx "--as-of=AAPL@$as_of_ts" tests/data/small_test.csv | tail -1)
+    # Default interval on many symbols: every query matches its symbol's
+    # last row at or before the time
+    ./analyzer --sma=20 --ema=50 --build-index=tests/output_test12.idx tests/data/medium.csv > tests/output_test12_full.csv 2>/dev/null
+    for n in 5000 40000 79000; do
+        row=$(sed -n "${n}p" tests/output_test12_full.csv)
+        symbol=$(echo "$row" | cut -d, -f2)
+        ts=$(echo "$row" | cut -d, -f1)
+        want=$(awk -F, -v s="$symbol" -v t="$ts" '$2 == s && $1 <= t { last = $0 } END { print last }' tests/output_test12_full.csv)
+        got=$(./analyzer --sma=20 --ema=50 --index=tests/output_test12.idx "--as-of=$symbol@$ts" tests/data/medium.csv | tail -1)
+        [ "$got" == "$want" ] || actual="medium.csv row $n: got '$got'"
+    done
+    # The index only answers for the input it was built from: an edit that
+    # keeps the size, or an appended row, is detected
+    sed '2s/0/1/' tests/data/medium.csv > tests/output_test12_input.csv
+    if ./analyzer --sma=20 --ema=50 --index=tests/output_test12.idx "--as-of=$symbol@$ts" tests/output_test12_input.csv > /dev/null 2>&1; then
+        actual="index accepted an edited input"
+    fi
+    (cat tests/data/medium.csv; echo "2023-12-31 00:00:00,$symbol,1.00,1") > tests/output_test12_input.csv
+    if ./analyzer --sma=20 --ema=50 --index=tests/output_test12.idx "--as-of=$symbol@$ts" tests/output_test12_input.csv > /dev/null 2>&1; then
+        actual="index accepted an appended input"
+    fi
+    if [ "$actual" == "$expected" ]; then
+        print_result 0 "As-of query (matches full run)"
+    else
+        print_result 1 "As-of query (got '$actual', expected '$expected')"
+    fi
+else
+    print_result 1 "As-of query (index build crashed)"
+fi
+rm -f tests/output_test12.idx
+
+# Test 13: Stage profile does not change the output
+echo "Test 13: Stage profile..."
+./analyzer --sma=3 --ema=5 --profile tests/data/small_test.csv > tests/output_test13.csv 2> tests/output_test13_err.csv
+if [ $? -eq 0 ] && cmp -s tests/output_test13.csv <(./analyzer --sma=3 --ema=5 tests/data/small_test.csv) && \
+   grep -q "cycles/row\|ticks/row" tests/output_test13_err.csv && grep -q "format" tests/output_test13_err.csv && \
+   ./analyzer --sma=3 --ema=5 --profile=hw tests/data/small_test.csv 2>/dev/null | cmp -s - tests/output_test13.csv; then
+    print_result 0 "Stage profile (report on stderr, identical output, hw falls back)"
+else
+    print_result 1 "Stage profile (missing report or changed output)"
+fi
+
+# Test 14: Progress reporting ends with a summary line
+echo "Test 14: Progress reporting..."
+./analyzer --sma=3 --progress=1s tests/data/small_test.csv > tests/output_test14.csv 2> tests/output_test14_err.csv
+if [ $? -eq 0 ] && [ $(wc -l < tests/output_test14.csv) -eq 6 ] && \
+   grep -q "^\[progress\].*(100.0%).*done in.*symbols=2" tests/output_test14_err.csv; then
+    print_result 0 "Progress reporting (final summary on stderr)"
+else
+    print_result 1 "Progress reporting (missing summary or rows)"
+fi
+
+# Test 15: Trace timeline is written as Chrome trace events
+echo "Test 15: Stage trace..."
+./analyzer --sma=3 --trace=tests/output_test15.json tests/data/small_test.csv > tests/output_test15.csv
+if [ $? -eq 0 ] && cmp -s tests/output_test15.csv <(./analyzer --sma=3 tests/data/small_test.csv) && \
+   grep -q '"name":"pipeline"' tests/output_test15.json && \
+   grep -q '"name":"parse","ph":"X"' tests/output_test15.json && \
+   tail -n 1 tests/output_test15.json | grep -q '^\]}$'; then
+    print_result 0 "Stage trace (Chrome trace events, output unchanged)"
+else
+    print_result 1 "Stage trace (missing events or changed output)"
+fi
+
+# Test 16: Optimized paths agree with the reference implementations
+echo "Test 16: Differential fuzz against reference..."
+if g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o tests/differential_test tests/differential_test.cpp 2>/dev/null; then
+    ./tests/differential_test --cases=100 > tests/output_test16.csv
+    if [ $? -eq 0 ]; then
+        print_result 0 "Differential fuzz (within tolerance of reference)"
+    else
+        cat tests/output_test16.csv
+        print_result 1 "Differential fuzz (optimized paths diverge from reference)"
+    fi
+    rm -f tests/differential_test
+else
+    print_result 1 "Differential fuzz (harness does not compile)"
+fi
+
+# Test 17: Engine API matches the command-line output for chunked input
+echo "Test 17: Embedded engine with chunked input..."
+if g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o tests/engine_test tests/engine_test.cpp src/engine.cpp 2>/dev/null; then
+    engine_ok=0
+    for flags in "--sma=3 --ema=5 --vol=3 --vwap=daily" "--sma=3 --symbol=AAPL" "--sma=3 --max-lateness=1m" "--ema=3 --pair=AAPL:MSFT:ratio"; do
+        if ! cmp -s <(./tests/engine_test $flags tests/data/small_test.csv 2>/dev/null) \
+                    <(./analyzer $flags tests/data/small_test.csv 2>/dev/null); then
+            engine_ok=1
+        fi
+    done
+    # Output that replaces rows cannot reach the callback
+    for flags in "--xsection=1m" "--summary" "--bars=ticks:2" "--latency=0" "--sweep=sma:2..4" "--backtest=sma:2/3" \
+                 "--config-file=tests/output_test_jobs.toml" "--index=tests/output_test.idx --as-of=AAPL@2023-09-15T09:31:00"; do
+        if ./tests/engine_test $flags tests/data/small_test.csv > /dev/null 2>&1; then
+            engine_ok=1
+        fi
+    done
+    print_result $engine_ok "Embedded engine (same rows as the analyzer)"
+    rm -f tests/engine_test
+else
+    print_result 1 "Embedded engine (does not compile or link)"
+fi
+
+# Test 18: Binary output decodes to the CSV output; null output is empty
+echo "Test 18: Output sinks..."
+if g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o tests/binary_output_test tests/binary_output_test.cpp 2>/dev/null; then
+    sinks_ok=0
+    for flags in "--sma=3 --ema=5 --vol=3 --vwap=daily" "--ema=5 --symbol=AAPL" "--sma=3 --pair=AAPL:MSFT:spread:0.5"; do
+        ./analyzer $flags --output=binary tests/data/small_test.csv > tests/output_test_sink.bin 2>/dev/null
+        if ! cmp -s <(./tests/binary_output_test tests/output_test_sink.bin) \
+                    <(./analyzer $flags tests/data/small_test.csv 2>/dev/null); then
+            sinks_ok=1
+        fi
+    done
+    if [ -n "$(./analyzer --sma=3 --output=null tests/data/small_test.csv 2>/dev/null)" ]; then
+        sinks_ok=1
+    fi
+    print_result $sinks_ok "Output sinks (binary round trip, null is silent)"
+    rm -f tests/binary_output_test tests/output_test_sink.bin
+else
+    print_result 1 "Output sinks (decoder does not compile)"
+fi
+
+# Test 19: C API result columns match the command-line output
+echo "Test 19: C API..."
+if gcc -std=c11 -Iinclude -c tests/capi_test.c -o tests/capi_test.o 2>/dev/null &&
+   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o tests/capi_test tests/capi_test.o src/capi.cpp src/engine.cpp 2>/dev/null; then
+    capi_ok=0
+    for flags in "--sma=3 --ema=5 --vol=3 --vwap=daily" "--vol=3 --symbol=AAPL" "--vwap=daily --pair=AAPL:MSFT:ratio"; do
+        if ! cmp -s <(./tests/capi_test "$flags" tests/data/small_test.csv 2>/dev/null) \
+                    <(./analyzer $flags tests/data/small_test.csv 2>/dev/null | tail -n +2 | cut -d, -f2-); then
+            capi_ok=1
+        fi
+    done
+    for flags in "--bogus=1" "--xsection=1m" "--summary" "--bars=ticks:2" "--latency=0" "--sweep=sma:2..4" "--backtest=sma:2/3" \
+                 "--config-file=tests/output_test_jobs.toml" "--index=tests/output_test.idx --as-of=AAPL@2023-09-15T09:31:00"; do
+        if ./tests/capi_test "$flags" tests/data/small_test.csv > /dev/null 2>&1; then
+            capi_ok=1
+        fi
+    done
+    print_result $capi_ok "C API (columns match the analyzer, bad flags rejected)"
+    rm -f tests/capi_test tests/capi_test.o
+else
+    print_result 1 "C API (does not compile or link)"
+fi
+
+# Test 20: Every job of a job file matches a standalone run with its flags
+echo "Test 20: Job file fan-out..."
+cat > tests/output_test_jobs.toml <<'JOBS'
+# Applies to every job
+ema = 5
+
+[[job]]
+output = "tests/output_test_job1.csv"
+sma = 3
+vwap = "daily"
+
+[[job]]
+output = "tests/output_test_job2.bin"
+format = "binary"
+symbol = "AAPL"
+vol = 3
+
+[[job]]
+output = "tests/output_test_job3.csv"
+max_lateness = "1m"
+JOBS
+fanout_ok=0
+if ./analyzer --config-file=tests/output_test_jobs.toml tests/data/small_test.csv > /dev/null 2>&1; then
+    cmp -s tests/output_test_job1.csv <(./analyzer --ema=5 --sma=3 --vwap=daily tests/data/small_test.csv 2>/dev/null) || fanout_ok=1
+    cmp -s tests/output_test_job2.bin <(./analyzer --ema=5 --symbol=AAPL --vol=3 --output=binary tests/data/small_test.csv 2>/dev/null) || fanout_ok=1
+    cmp -s tests/output_test_job3.csv <(./analyzer --ema=5 --max-lateness=1m tests/data/small_test.csv 2>/dev/null) || fanout_ok=1
+else
+    fanout_ok=1
+fi
+# Each job's warnings are printed whole, after the jobs finish
+printf '[[job]]\noutput = "tests/output_test_job1.csv"\ncorrections = 2\n[[job]]\noutput = "tests/output_test_job2.csv"\ncorrections = 2\n' > tests/output_test_jobs.toml
+(cat tests/data/small_test.csv; echo "2023-09-15 09:40:00,AAPL,150.00,100,X") > tests/output_test_jobs_input.csv
+./analyzer --config-file=tests/output_test_jobs.toml tests/output_test_jobs_input.csv 2> tests/output_test_jobs_err.csv > /dev/null
+for n in 1 2; do
+    grep -qx "Job writing 'tests/output_test_job$n.csv': Warning: 1 corrections did not match a journaled trade" tests/output_test_jobs_err.csv || fanout_ok=1
+done
+printf '[[job]]\noutput = "tests/output_test_job1.csv"\nlatency = "1s"\n' > tests/output_test_jobs.toml
+if ./analyzer --config-file=tests/output_test_jobs.toml tests/data/small_test.csv > /dev/null 2>&1; then
+    fanout_ok=1
+fi
+print_result $fanout_ok "Job file fan-out (outputs match standalone runs, bad jobs rejected)"
+rm -f tests/output_test_jobs.toml tests/output_test_jobs_* tests/output_test_job*
+
+# Test 21: Every column of a sweep matrix matches a run with that parameter
+echo "Test 21: Parameter sweep..."
+if g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude -o tests/sweep_test tests/sweep_test.cpp 2>/dev/null; then
+    sweep_ok=0
+    ./analyzer --sweep=sma:1..6 --threads=4 tests/data/small_test.csv > tests/output_test_sweep.bin 2>/dev/null || sweep_ok=1
+    for w in 1 3 6; do
+        cmp -s <(./tests/sweep_test tests/output_test_sweep.bin $w) \
+               <(./analyzer --sma=$w tests/data/small_test.csv 2>/dev/null) || sweep_ok=1
+    done
+    ./analyzer --sweep=ema:2..10:4 --symbol=AAPL tests/data/small_test.csv > tests/output_test_sweep.bin 2>/dev/null || sweep_ok=1
+    for span in 2 6 10; do
+        cmp -s <(./tests/sweep_test tests/output_test_sweep.bin $span) \
+               <(./analyzer --ema=$span --symbol=AAPL tests/data/small_test.csv 2>/dev/null) || sweep_ok=1
+    done
+    if ./analyzer --sweep=sma:5..2 tests/data/small_test.csv > /dev/null 2>&1; then
+        sweep_ok=1
+    fi
+    print_result $sweep_ok "Parameter sweep (columns match single runs, bad ranges rejected)"
+    rm -f tests/sweep_test tests/output_test_sweep.bin
+else
+    print_result 1 "Parameter sweep (decoder does not compile)"
+fi
+
+# Test 22: Backtest of a hand-checked case; grid rows equal single rules
+echo "Test 22: Crossover backtest..."
+printf '%s\n' "2023-01-02 10:00:00,X,10,1" "2023-01-02 10:00:01,X,11,1" \
+    "2023-01-02 10:00:02,X,12,1" "2023-01-02 10:00:03,X,11,1" \
+    "2023-01-02 10:00:04,X,13,1" "2023-01-02 10:00:05,X,12,1" > tests/output_test_bt.csv
+backtest_ok=0
+# Long after 12 and 13, exiting at 11 and 12: -1/12 - 1/13 less 4 x 1%
+if [ "$(./analyzer --backtest=sma:1/2 --cost=100 tests/output_test_bt.csv 2>/dev/null | tail -n 1)" != \
+     "X,1,2,-0.200256,4,-0.871597,0.200256" ]; then
+    backtest_ok=1
+fi
+./analyzer --backtest=ema:1..3/2..5 --threads=3 tests/data/small_test.csv > tests/output_test_grid.csv 2>/dev/null || backtest_ok=1
+cmp -s tests/output_test_grid.csv <(./analyzer --backtest=ema:1..3/2..5 --threads=1 tests/data/small_test.csv 2>/dev/null) || backtest_ok=1
+if [ "$(grep '^AAPL,2,3,' tests/output_test_grid.csv)" != \
+     "$(./analyzer --backtest=ema:2/3 tests/data/small_test.csv 2>/dev/null | grep '^AAPL,')" ]; then
+    backtest_ok=1
+fi
+if ./analyzer --backtest=sma:50/20 tests/data/small_test.csv > /dev/null 2>&1; then
+    backtest_ok=1
+fi
+print_result $backtest_ok "Crossover backtest (expected PnL, grid matches single rules)"
+rm -f tests/output_test_bt.csv tests/output_test_grid.csv
+
+# Test 23: Cross-section of a hand-checked case; per-symbol rows match the
+# universe summary
+echo "Test 23: Cross-sectional buckets..."
+xsection_ok=0
+# 09:32 bucket: AAPL 150.30 -> 150.10, MSFT new at 285.20
+if [ "$(./analyzer --xsection=1m tests/data/small_test.csv 2>/dev/null | sed -n 3,4p | tr '\n' ' ')" != \
+     "2023-09-15 09:32:00,AAPL,150.100000,-0.001331,2,-1.000000 2023-09-15 09:32:00,MSFT,285.200000,0.000000,1,1.000000 " ]; then
+    xsection_ok=1
+fi
+if [ "$(./analyzer --xsection=1m:universe tests/data/small_test.csv 2>/dev/null | tail -n 1)" != \
+     "2023-09-15 09:33:00,2,0.000526,0.000526,0.000000,0.001052,1,0" ]; then
+    xsection_ok=1
+fi
+# A zero price has no return: the symbol is left out instead of a NaN
+sed '2a 2023-09-15 09:30:40,ZERO,0.00,100' tests/data/small_test.csv > tests/output_test_xsection_zero.csv
+if [ "$(./analyzer --xsection=1m:universe tests/output_test_xsection_zero.csv 2>/dev/null | tail -n 1)" != \
+     "2023-09-15 09:33:00,2,0.000526,0.000526,0.000000,0.001052,1,0" ] ||
+   ./analyzer --xsection=1m tests/output_test_xsection_zero.csv 2>/dev/null | grep -q "ZERO\|nan"; then
+    xsection_ok=1
+fi
+rm -f tests/output_test_xsection_zero.csv
+symbol_rows=$(./analyzer --xsection=5m tests/data/medium.csv 2>/dev/null | tail -n +2 | wc -l)
+summary_symbols=$(./analyzer --xsection=5m:universe tests/data/medium.csv 2>/dev/null | tail -n +2 | awk -F, '{ n += $2 } END { print n }')
+[ "$symbol_rows" -gt 0 ] && [ "$symbol_rows" -eq "$summary_symbols" ] || xsection_ok=1
+if ./analyzer --xsection=1m --output=binary tests/data/small_test.csv > /dev/null 2>&1; then
+    xsection_ok=1
+fi
+print_result $xsection_ok "Cross-sectional buckets (expected ranks, z-scores and summaries)"
+
+# Test 24: Basket rows equal the weighted sum taken from scratch; the other
+# rows are unchanged
+echo "Test 24: Weighted baskets..."
+printf '%s\n' "symbol,weight" "AAPL,0.3" "MSFT,0.25" "NVDA,-0.4" "JPM,1.5" > tests/output_test_weights.csv
+basket_ok=0
+./analyzer --basket=IDX:tests/output_test_weights.csv --sma=20 tests/data/medium.csv > tests/output_test_basket.csv 2>/dev/null || basket_ok=1
+basket_check=$(awk -F, 'BEGIN { w["AAPL"] = 0.3; w["MSFT"] = 0.25; w["NVDA"] = -0.4; w["JPM"] = 1.5 }
+    NR > 1 { if ($2 == "IDX") { s = 0; for (k in w) s += w[k] * p[k]
+                                if (sprintf("%.6f", s) != $3) bad++; n++ }
+             else p[$2] = $3 }
+    END { print n + 0, bad + 0 }' tests/output_test_basket.csv)
+[ "${basket_check% *}" -gt 0 ] && [ "${basket_check#* }" -eq 0 ] || basket_ok=1
+cmp -s <(grep -v ',IDX,' tests/output_test_basket.csv) <(./analyzer --sma=20 tests/data/medium.csv 2>/dev/null) || basket_ok=1
+if ./analyzer --basket=IDX:tests/output_test_weights.csv --xsection=1m tests/data/small_test.csv > /dev/null 2>&1; then
+    basket_ok=1
+fi
+print_result $basket_ok "Weighted baskets (incremental value matches a full re-sum)"
+
+# Test 25: Pair series of a hand-checked case; z-scores match a window
+# recomputed from scratch
+echo "Test 25: Pair spreads and ratios..."
+pair_ok=0
+# Spread 7.70, 7.50, 7.35: z = (7.35 - 7.516667) / 0.175594
+if [ "$(./analyzer --pair=AAPL:MSFT:spread:0.5 --pair-window=3 tests/data/small_test.csv 2>/dev/null | tail -n 1)" != \
+     "2023-09-15 09:32:00,AAPL-0.5*MSFT,7.350000,900,-0.949158" ]; then
+    pair_ok=1
+fi
+./analyzer --pair=AAPL:MSFT:ratio --pair=JPM:V:spread:0.8 --pair-window=20 tests/data/medium.csv > tests/output_test_pairs.csv 2>/dev/null || pair_ok=1
+pair_check=$(awk -F, -v W=20 'NR > 1 && $2 ~ /[\/*]/ {
+        k = $2; n[k]++; ring[k, n[k] % W] = $3; m = n[k] < W ? n[k] : W
+        s = 0; for (i = 0; i < m; i++) s += ring[k, (n[k] - i) % W]
+        mean = s / m; ss = 0
+        for (i = 0; i < m; i++) ss += (ring[k, (n[k] - i) % W] - mean) ^ 2
+        z = (m > 1 && ss > 0) ? ($3 - mean) / sqrt(ss / (m - 1)) : 0
+        rows++; if (($5 - z) ^ 2 > 1e-6) bad++ }
+    END { print rows + 0, bad + 0 }' tests/output_test_pairs.csv)
+[ "${pair_check% *}" -gt 0 ] && [ "${pair_check#* }" -eq 0 ] || pair_ok=1
+cmp -s <(grep -v -e '/' -e '\*' tests/output_test_pairs.csv | cut -d, -f1-4) <(./analyzer tests/data/medium.csv 2>/dev/null) || pair_ok=1
+if ./analyzer --pair=AAPL:MSFT:ratio --xsection=1m tests/data/small_test.csv > /dev/null 2>&1; then
+    pair_ok=1
+fi
+print_result $pair_ok "Pair series (expected spread, rolling z-scores)"
+
+# Test 26: Summary rows match aggregates of the per-row output
+echo "Test 26: Per-symbol summary..."
+summary_ok=0
+flags="--sma=20 --ema=50 --vol=30 --vwap=daily"
+./analyzer $flags --summary tests/data/medium.csv > tests/output_test_summary.csv 2>/dev/null || summary_ok=1
+./analyzer $flags tests/data/medium.csv 2>/dev/null | awk -F, 'NR > 1 {
+        s = $2; if (!(s in n)) { order[++k] = s; first[s] = $1; lo[s] = $3; hi[s] = $3; peak[s] = 0; dd[s] = 0 }
+        n[s]++; last[s] = $1; vol[s] += $4; sum[s] += $3
+        if ($3 < lo[s]) lo[s] = $3; if ($3 > hi[s]) hi[s] = $3
+        if ($3 > peak[s]) peak[s] = $3; if ((peak[s] - $3) / peak[s] > dd[s]) dd[s] = (peak[s] - $3) / peak[s]
+        ind[s] = $5 "," $6 "," $7 "," $8 }
+    END { print "symbol,count,first_timestamp,last_timestamp,min_price,max_price,mean_price,total_volume,sma,ema,volatility,vwap,max_drawdown"
+          for (i = 1; i <= k; i++) { s = order[i]
+              printf "%s,%d,%s,%s,%s,%s,%.6f,%d,%s,%.6f\n", s, n[s], first[s], last[s], lo[s], hi[s], sum[s] / n[s], vol[s], ind[s], dd[s] } }' \
+    > tests/output_test_summary_expected.csv
+cmp -s tests/output_test_summary.csv tests/output_test_summary_expected.csv || summary_ok=1
+if ./analyzer --summary --xsection=1m tests/data/small_test.csv > /dev/null 2>&1; then
+    summary_ok=1
+fi
+print_result $summary_ok "Per-symbol summary (matches aggregates of the rows)"
+
+# Test 27: Volume, dollar and tick bars
+echo "Test 27: Information-driven bars..."
+bars_ok=0
+cat > tests/output_test_bars_expected.csv <<'EXPECTED'
+timestamp,symbol,open,high,low,close,volume,dollar_volume,ticks,sma
+2023-09-15 09:30:00,AAPL,150.250000,150.250000,150.250000,150.250000,1000,150250.000000,1,0.000000
+2023-09-15 09:30:30,AAPL,150.300000,150.300000,150.300000,150.300000,1000,150300.000000,1,150.300000
+2023-09-15 09:31:30,AAPL,150.300000,150.300000,150.100000,150.100000,1000,150200.000000,2,150.200000
+2023-09-15 09:32:00,MSFT,285.200000,285.500000,285.200000,285.500000,1000,285260.000000,2,0.000000
+EXPECTED
+./analyzer --bars=volume:1000 --sma=2 tests/data/small_test.csv 2>/dev/null | cmp -s - tests/output_test_bars_expected.csv || bars_ok=1
+# Every volume bar holds exactly N shares, and all but the remainder are used
+./analyzer --bars=volume:50000 tests/data/medium.csv > tests/output_test_bars.csv 2>/dev/null || bars_ok=1
+awk -F, 'NR == FNR { if (FNR > 1) { if ($7 != 50000) bad = 1; n[$2]++ } next }
+    { v[$2] += $4 }
+    END { for (s in v) if (n[s] != int(v[s] / 50000)) bad = 1; exit bad }' \
+    tests/output_test_bars.csv tests/data/medium.csv || bars_ok=1
+# Tick bars: floor(trades / N) bars per symbol
+./analyzer --bars=ticks:100 tests/data/medium.csv > tests/output_test_bars.csv 2>/dev/null || bars_ok=1
+awk -F, 'NR == FNR { if (FNR > 1) { if ($9 != 100) bad = 1; n[$2]++ } next }
+    { t[$2]++ }
+    END { for (s in t) if (n[s] != int(t[s] / 100)) bad = 1; exit bad }' \
+    tests/output_test_bars.csv tests/data/medium.csv || bars_ok=1
+# Dollar bars reach the threshold, and would not without their last share
+./analyzer --bars=dollar:1e6 tests/data/medium.csv > tests/output_test_bars.csv 2>/dev/null || bars_ok=1
+awk -F, 'NR > 1 { if ($8 < 1e6 - 1e-6 || $8 - $6 >= 1e6) bad = 1; rows++ }
+    END { exit bad || rows == 0 }' tests/output_test_bars.csv || bars_ok=1
+if ./analyzer --bars=volume:10 --summary tests/data/small_test.csv > /dev/null 2>&1; then
+    bars_ok=1
+fi
+if ./analyzer --bars=volume:1.5 tests/data/small_test.csv > /dev/null 2>&1; then
+    bars_ok=1
+fi
+print_result $bars_ok "Information-driven bars (trades split at thresholds)"
+
+# Test 28: Durations that overflow 64-bit nanoseconds are rejected
+echo "Test 28: Duration overflow..."
+./analyzer --latency=99999999999h tests/data/small_test.csv > /dev/null 2>&1
+if [ $? -ne 0 ]; then
+    print_result 0 "Duration overflow (rejected)"
+else
+    print_result 1 "Duration overflow (should be rejected)"
+fi
+
 # Performance test (if large file exists)
 if [ -f "tests/data/large_test.csv" ]; then
-    echo "Test 9: Performance test (5M rows)..."
+    echo "Test 29: Performance test (5M rows)..."
     start_time=$(date +%s)
     ./analyzer --sma=20 --ema=50 tests/data/large_test.csv > /dev/null 2>&1
     end_time=$(date +%s)
@@ -156,7 +605,7 @@ else
 fi
 
 # Clean up test output files
-rm -f tests/output_test*.csv
+rm -f tests/output_test*.csv tests/output_test*.json
 
 # Summary
 echo
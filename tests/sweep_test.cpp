@@ -0,0 +1,78 @@
+#include "../include/indicators.hpp"
+#include "../include/sink.hpp"
+#include "../include/sweep.hpp"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file sweep_test.cpp
+ * @brief Extracts one parameter's column from a `--sweep` matrix as CSV
+ *
+ * Reads the stream with SweepReader and formats the chosen column through
+ * CsvSink as the sma or ema column, so the output can be compared with a
+ * plain run of the analyzer with that window or span.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -march=native -DNDEBUG -Iinclude \
+ *       -o sweep_test tests/sweep_test.cpp
+ *   ./analyzer --sweep=sma:2..50 data.csv > sweep.bin
+ *   ./sweep_test sweep.bin 20    # compare with: ./analyzer --sma=20 ...
+ */
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: sweep_test sweep.bin PARAMETER\n";
+    return 1;
+  }
+  try {
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open file '" << argv[1] << "'\n";
+      return 1;
+    }
+    SweepReader reader(file);
+    const auto column = std::find(reader.parameters.begin(),
+                                  reader.parameters.end(), std::stoi(argv[2]));
+    if (column == reader.parameters.end()) {
+      std::cerr << "Error: " << argv[2] << " was not swept\n";
+      return 1;
+    }
+    const size_t k = static_cast<size_t>(column - reader.parameters.begin());
+    const size_t width = reader.parameters.size();
+
+    ResultColumns columns;
+    (reader.indicator == "sma" ? columns.sma : columns.ema) = true;
+    CsvSink sink(std::cout);
+    sink.begin(columns);
+
+    std::vector<std::string> timestamps;
+    std::vector<std::string_view> timestamp_views;
+    std::vector<std::string_view> symbols;
+    std::vector<double> values;
+    while (reader.next()) {
+      const size_t n = reader.prices.size();
+      timestamps.clear();
+      values.clear();
+      for (size_t i = 0; i < n; ++i) {
+        timestamps.push_back(format_timestamp_ns(reader.ts_ns[i]));
+        values.push_back(reader.values[i * width + k]);
+      }
+      timestamp_views.assign(timestamps.begin(), timestamps.end());
+      symbols.assign(reader.symbols.begin(), reader.symbols.end());
+      std::span<const double> none;
+      sink.write({n, timestamp_views, reader.symbol_ids, symbols,
+                  reader.prices, reader.volumes, columns.sma ? values : none,
+                  columns.ema ? values : none, none, none, none});
+      sink.commit(false);
+    }
+    return 0;
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << '\n';
+    return 1;
+  }
+}